@@ -0,0 +1,197 @@
+// Raster and flush benchmark. Runs the driver against Nokia5110Emulator, so
+// it measures the drawing code without the SPI bus. Build it on a host with
+//
+//   g++ -O2 -Isrc src/*.cpp examples/benchmark.cpp -o benchmark
+//
+// Each line of output is one CSV record:
+//   primitive,size,mode,pattern,iterations,ns_per_call,pixels,pixels_per_sec,spi_bytes
+//
+// pixels is the number of pixels one call touches, and spi_bytes is the
+// number of bytes (commands and data) display_dirty() sends after one call
+
+#include <stdio.h>
+#include <Nokia5110.h>
+#include <Nokia5110Emulator.h>
+#include <Nokia5110Surface.h>
+
+#ifdef __MBED__
+#include <mbed.h>
+
+static Timer timer;
+
+static void timer_start() {
+    timer.reset();
+    timer.start();
+}
+
+static double timer_ns() {
+    return timer.read_us() * 1000.0;
+}
+#else
+#include <chrono>
+
+static std::chrono::steady_clock::time_point start_time;
+
+static void timer_start() {
+    start_time = std::chrono::steady_clock::now();
+}
+
+static double timer_ns() {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+}
+#endif
+
+// minimum time to spend on each case
+#define BENCH_NS 20000000.0
+
+enum Primitive {
+    fill_rect,
+    fill_circle,
+    fill_ellipse,
+    draw_line,
+    print_string,
+    print_scaled,
+    draw_bitmap,
+    draw_wbitmap,
+    blit,
+    primitive_count
+};
+
+static const char *primitive_names[] = {
+    "fill_rect", "fill_circle", "fill_ellipse", "draw_line", "print_string", "print_scaled", "draw_bitmap", "draw_wbitmap", "blit"
+};
+
+static const char *mode_names[] = {
+    "pixel_copy", "pixel_or", "pixel_xor", "pixel_clr", "pixel_invt", "pixel_nor", "pixel_xnor", "pixel_nclr"
+};
+
+static const Nokia5110::Pattern *patterns[] = {
+    &Nokia5110::pattern_black, &Nokia5110::pattern_dkgrey, &Nokia5110::pattern_grey, &Nokia5110::pattern_ltgrey, &Nokia5110::pattern_white
+};
+
+static const char *pattern_names[] = {
+    "pattern_black", "pattern_dkgrey", "pattern_grey", "pattern_ltgrey", "pattern_white"
+};
+
+static const uint8_t sizes[] = {4, 8, 16, 32, 47};
+
+static const char text[] = "The quick brown fox jumps over";
+
+static uint8_t bitmap[LCD_BYTES];
+static uint8_t wbitmap[4 + LCD_BYTES];
+
+static Nokia5110Surface<LCD_WIDTH, LCD_HEIGHT> surface;
+
+static Nokia5110Emulator emulator;
+static Nokia5110 lcd(emulator);
+
+static void draw(Primitive primitive, uint8_t size, Nokia5110::Mode mode, const Nokia5110::Pattern &pattern) {
+    switch (primitive) {
+    case fill_rect:
+        lcd.fill_rect(1, 0, size, size - 1, pattern, mode);
+        break;
+    case fill_circle:
+        lcd.fill_circle(size / 2, size / 2, size / 2, pattern, mode);
+        break;
+    case fill_ellipse:
+        lcd.fill_ellipse(size / 2, size / 4, size / 2, size / 4, pattern, mode);
+        break;
+    case draw_line:
+        lcd.draw_line(0, 1, size, size / 2 + 1, pattern, mode);
+        break;
+    case print_string:
+        lcd.print_string(text, 1, 3, size / 4, mode);
+        break;
+    case print_scaled:
+        lcd.print_scaled("42.7", 1, 3, 1 + size / 12, mode);
+        break;
+    case draw_bitmap:
+        lcd.draw_bitmap(bitmap, 1, 3, size, size, mode);
+        break;
+    case draw_wbitmap:
+        wbitmap[2] = size;
+        wbitmap[3] = size;
+        lcd.draw_wbitmap(wbitmap, 1, 3, mode);
+        break;
+    case blit:
+        lcd.blit(surface, 0, 0, size - 1, size - 1, 1, 3, mode);
+        break;
+    default:
+        break;
+    }
+}
+
+static unsigned int count_pixels() {
+    unsigned int count = 0;
+    for (uint8_t bank = 0; bank < LCD_BANKS; bank++) {
+        for (uint8_t col = 0; col < LCD_WIDTH; col++) {
+            for (uint8_t byte = lcd.get_byte(col, bank); byte; byte &= byte - 1) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+static void run(Primitive primitive, uint8_t size, uint8_t mode, uint8_t pattern) {
+    const Nokia5110::Pattern &pat = (pattern < 5) ? *patterns[pattern] : Nokia5110::pattern_black;
+
+    // pixels touched by one call: xor a solid shape onto a blank screen
+    lcd.clear_buffer();
+    draw(primitive, size, Nokia5110::pixel_xor, Nokia5110::pattern_black);
+    unsigned int pixels = count_pixels();
+
+    // bytes on the bus to flush one call
+    lcd.clear_buffer();
+    lcd.display();
+    draw(primitive, size, (Nokia5110::Mode) mode, pat);
+    emulator.reset_counters();
+    lcd.display_dirty();
+    unsigned long spi_bytes = emulator.command_bytes() + emulator.data_bytes();
+
+    unsigned long iterations = 0;
+    double ns;
+    timer_start();
+    do {
+        for (unsigned int i = 0; i < 64; i++) {
+            draw(primitive, size, (Nokia5110::Mode) mode, pat);
+        }
+        iterations += 64;
+        ns = timer_ns();
+    } while (ns < BENCH_NS);
+
+    double ns_per_call = ns / iterations;
+    printf("%s,%u,%s,%s,%lu,%.1f,%u,%.0f,%lu\n",
+           primitive_names[primitive], size, mode_names[mode], (pattern < 5) ? pattern_names[pattern] : "-",
+           iterations, ns_per_call, pixels, pixels * 1e9 / ns_per_call, spi_bytes);
+}
+
+int main() {
+    for (unsigned int i = 0; i < sizeof(bitmap); i++) {
+        bitmap[i] = (i * 37) ^ (i >> 2);
+        wbitmap[4 + i] = bitmap[i];
+    }
+    surface.draw_native_bitmap(bitmap, 0, 0, LCD_WIDTH, LCD_HEIGHT);
+
+    lcd.init();
+
+    printf("primitive,size,mode,pattern,iterations,ns_per_call,pixels,pixels_per_sec,spi_bytes\n");
+    for (unsigned int primitive = 0; primitive < primitive_count; primitive++) {
+        // text and bitmaps dont take a pattern
+        bool patterned = primitive <= draw_line;
+
+        for (unsigned int s = 0; s < sizeof(sizes); s++) {
+            for (uint8_t mode = 0; mode < 8; mode++) {
+                for (uint8_t pattern = 0; pattern < (patterned ? 5 : 1); pattern++) {
+                    run((Primitive) primitive, sizes[s], mode, patterned ? pattern : 5);
+                }
+            }
+        }
+    }
+
+    // cost of a whole frame on the bus
+    emulator.reset_counters();
+    lcd.display();
+    lcd.display();
+    printf("display,%u,-,-,1,0,%u,0,%lu\n", LCD_BYTES, LCD_WIDTH * LCD_HEIGHT, (emulator.command_bytes() + emulator.data_bytes()) / 2);
+}
@@ -1,7 +1,8 @@
 #include <mbed.h>
 #include <Nokia5110.h>
 
-uint8_t dog1[51] = {
+// 24x17, row-major, MSB first
+constexpr uint8_t dog1[51] = {
     0x5E, 0x80, 0x00,
     0x7F, 0x80, 0x00,
     0x7F, 0xC0, 0x00,
@@ -21,10 +22,14 @@ uint8_t dog1[51] = {
     0x40, 0x01, 0x00
 };
 
+// converted to the display's bank format at compile time
+constexpr NativeBitmap<24, 17> dog1_native = to_native_bitmap<24, 17>(dog1);
+
 int main() {
     Nokia5110 display(p4, p3, p5, p6, p7);
     display.init(0x2C);
     display.clear_buffer();
     display.draw_bitmap(dog1, 5, 5, 24, 17);
+    display.draw_native_bitmap(dog1_native, 45, 5);
     display.display();
 }
@@ -0,0 +1,29 @@
+#include <mbed.h>
+#include <Nokia5110.h>
+#include <Nokia5110Console.h>
+
+Nokia5110 display(p4, p3, p5, p6, p7);
+
+// the bottom 5 lines scroll, the top line is left for a title
+Nokia5110Console console(display, 1, 5);
+
+// send printf() and friends to the display
+namespace mbed {
+FileHandle *mbed_override_console(int fd) {
+    (void) fd;
+    return &console;
+}
+}
+
+int main() {
+    display.init(0x2C);
+    display.clear_buffer();
+    display.print_string("Log", 33, 0);
+    display.draw_hline(0, 83, 7);
+    display.display();
+
+    for (unsigned int i = 0;; i++) {
+        printf("tick %u\n", i);
+        wait_ms(500);
+    }
+}
@@ -0,0 +1,161 @@
+#include <mbed.h>
+#include <Nokia5110.h>
+
+// generated with python3 tools/bdf2font.py tools/prop5x7.bdf prop5x7
+static constexpr uint8_t prop5x7_data[419] = {
+    0x5F, 0x07, 0x00, 0x07, 0x14, 0x7F, 0x14, 0x7F, 0x14, 0x24, 0x2A, 0x7F,
+    0x2A, 0x12, 0x23, 0x13, 0x08, 0x64, 0x62, 0x36, 0x49, 0x55, 0x22, 0x50,
+    0x05, 0x03, 0x1C, 0x22, 0x41, 0x41, 0x22, 0x1C, 0x08, 0x2A, 0x1C, 0x2A,
+    0x08, 0x08, 0x08, 0x3E, 0x08, 0x08, 0x50, 0x30, 0x08, 0x08, 0x08, 0x08,
+    0x08, 0x60, 0x60, 0x20, 0x10, 0x08, 0x04, 0x02, 0x3E, 0x51, 0x49, 0x45,
+    0x3E, 0x42, 0x7F, 0x40, 0x42, 0x61, 0x51, 0x49, 0x46, 0x21, 0x41, 0x45,
+    0x4B, 0x31, 0x18, 0x14, 0x12, 0x7F, 0x10, 0x27, 0x45, 0x45, 0x45, 0x39,
+    0x3C, 0x4A, 0x49, 0x49, 0x30, 0x01, 0x71, 0x09, 0x05, 0x03, 0x36, 0x49,
+    0x49, 0x49, 0x36, 0x06, 0x49, 0x49, 0x29, 0x1E, 0x36, 0x36, 0x56, 0x36,
+    0x08, 0x14, 0x22, 0x41, 0x14, 0x14, 0x14, 0x14, 0x14, 0x41, 0x22, 0x14,
+    0x08, 0x02, 0x01, 0x51, 0x09, 0x06, 0x32, 0x49, 0x79, 0x41, 0x3E, 0x7E,
+    0x11, 0x11, 0x11, 0x7E, 0x7F, 0x49, 0x49, 0x49, 0x36, 0x3E, 0x41, 0x41,
+    0x41, 0x22, 0x7F, 0x41, 0x41, 0x22, 0x1C, 0x7F, 0x49, 0x49, 0x49, 0x41,
+    0x7F, 0x09, 0x09, 0x01, 0x01, 0x3E, 0x41, 0x41, 0x51, 0x32, 0x7F, 0x08,
+    0x08, 0x08, 0x7F, 0x41, 0x7F, 0x41, 0x20, 0x40, 0x41, 0x3F, 0x01, 0x7F,
+    0x08, 0x14, 0x22, 0x41, 0x7F, 0x40, 0x40, 0x40, 0x40, 0x7F, 0x02, 0x04,
+    0x02, 0x7F, 0x7F, 0x04, 0x08, 0x10, 0x7F, 0x3E, 0x41, 0x41, 0x41, 0x3E,
+    0x7F, 0x09, 0x09, 0x09, 0x06, 0x3E, 0x41, 0x51, 0x21, 0x5E, 0x7F, 0x09,
+    0x19, 0x29, 0x46, 0x46, 0x49, 0x49, 0x49, 0x31, 0x01, 0x01, 0x7F, 0x01,
+    0x01, 0x3F, 0x40, 0x40, 0x40, 0x3F, 0x1F, 0x20, 0x40, 0x20, 0x1F, 0x7F,
+    0x20, 0x18, 0x20, 0x7F, 0x63, 0x14, 0x08, 0x14, 0x63, 0x03, 0x04, 0x78,
+    0x04, 0x03, 0x61, 0x51, 0x49, 0x45, 0x43, 0x7F, 0x41, 0x41, 0x02, 0x04,
+    0x08, 0x10, 0x20, 0x41, 0x41, 0x7F, 0x04, 0x02, 0x01, 0x02, 0x04, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x01, 0x02, 0x04, 0x20, 0x54, 0x54, 0x54, 0x78,
+    0x7F, 0x48, 0x44, 0x44, 0x38, 0x38, 0x44, 0x44, 0x44, 0x20, 0x38, 0x44,
+    0x44, 0x48, 0x7F, 0x38, 0x54, 0x54, 0x54, 0x18, 0x08, 0x7E, 0x09, 0x01,
+    0x02, 0x08, 0x14, 0x54, 0x54, 0x3C, 0x7F, 0x08, 0x04, 0x04, 0x78, 0x44,
+    0x7D, 0x40, 0x20, 0x40, 0x44, 0x3D, 0x7F, 0x10, 0x28, 0x44, 0x41, 0x7F,
+    0x40, 0x7C, 0x04, 0x18, 0x04, 0x78, 0x7C, 0x08, 0x04, 0x04, 0x78, 0x38,
+    0x44, 0x44, 0x44, 0x38, 0x7C, 0x14, 0x14, 0x14, 0x08, 0x08, 0x14, 0x14,
+    0x18, 0x7C, 0x7C, 0x08, 0x04, 0x04, 0x08, 0x48, 0x54, 0x54, 0x54, 0x20,
+    0x04, 0x3F, 0x44, 0x40, 0x20, 0x3C, 0x40, 0x40, 0x20, 0x7C, 0x1C, 0x20,
+    0x40, 0x20, 0x1C, 0x3C, 0x40, 0x30, 0x40, 0x3C, 0x44, 0x28, 0x10, 0x28,
+    0x44, 0x0C, 0x50, 0x50, 0x50, 0x3C, 0x44, 0x64, 0x54, 0x4C, 0x44, 0x08,
+    0x36, 0x41, 0x7F, 0x41, 0x36, 0x08, 0x08, 0x08, 0x2A, 0x1C, 0x08,
+};
+
+static constexpr Nokia5110Glyph prop5x7_glyphs[95] = {
+    {0, 0, 0, 3}, // ' '
+    {0, 0, 1, 2}, // '!'
+    {1, 0, 3, 4}, // '"'
+    {4, 0, 5, 6}, // '#'
+    {9, 0, 5, 6}, // '$'
+    {14, 0, 5, 6}, // '%'
+    {19, 0, 5, 6}, // '&'
+    {24, 0, 2, 3}, // "'"
+    {26, 0, 3, 4}, // '('
+    {29, 0, 3, 4}, // ')'
+    {32, 0, 5, 6}, // '*'
+    {37, 0, 5, 6}, // '+'
+    {42, 0, 2, 3}, // ','
+    {44, 0, 5, 6}, // '-'
+    {49, 0, 2, 3}, // '.'
+    {51, 0, 5, 6}, // '/'
+    {56, 0, 5, 6}, // '0'
+    {61, 0, 3, 4}, // '1'
+    {64, 0, 5, 6}, // '2'
+    {69, 0, 5, 6}, // '3'
+    {74, 0, 5, 6}, // '4'
+    {79, 0, 5, 6}, // '5'
+    {84, 0, 5, 6}, // '6'
+    {89, 0, 5, 6}, // '7'
+    {94, 0, 5, 6}, // '8'
+    {99, 0, 5, 6}, // '9'
+    {104, 0, 2, 3}, // ':'
+    {106, 0, 2, 3}, // ';'
+    {108, 0, 4, 5}, // '<'
+    {112, 0, 5, 6}, // '='
+    {117, 0, 4, 5}, // '>'
+    {121, 0, 5, 6}, // '?'
+    {126, 0, 5, 6}, // '@'
+    {131, 0, 5, 6}, // 'A'
+    {136, 0, 5, 6}, // 'B'
+    {141, 0, 5, 6}, // 'C'
+    {146, 0, 5, 6}, // 'D'
+    {151, 0, 5, 6}, // 'E'
+    {156, 0, 5, 6}, // 'F'
+    {161, 0, 5, 6}, // 'G'
+    {166, 0, 5, 6}, // 'H'
+    {171, 0, 3, 4}, // 'I'
+    {174, 0, 5, 6}, // 'J'
+    {179, 0, 5, 6}, // 'K'
+    {184, 0, 5, 6}, // 'L'
+    {189, 0, 5, 6}, // 'M'
+    {194, 0, 5, 6}, // 'N'
+    {199, 0, 5, 6}, // 'O'
+    {204, 0, 5, 6}, // 'P'
+    {209, 0, 5, 6}, // 'Q'
+    {214, 0, 5, 6}, // 'R'
+    {219, 0, 5, 6}, // 'S'
+    {224, 0, 5, 6}, // 'T'
+    {229, 0, 5, 6}, // 'U'
+    {234, 0, 5, 6}, // 'V'
+    {239, 0, 5, 6}, // 'W'
+    {244, 0, 5, 6}, // 'X'
+    {249, 0, 5, 6}, // 'Y'
+    {254, 0, 5, 6}, // 'Z'
+    {259, 0, 3, 4}, // '['
+    {262, 0, 5, 6}, // '\\'
+    {267, 0, 3, 4}, // ']'
+    {270, 0, 5, 6}, // '^'
+    {275, 0, 5, 6}, // '_'
+    {280, 0, 3, 4}, // '`'
+    {283, 0, 5, 6}, // 'a'
+    {288, 0, 5, 6}, // 'b'
+    {293, 0, 5, 6}, // 'c'
+    {298, 0, 5, 6}, // 'd'
+    {303, 0, 5, 6}, // 'e'
+    {308, 0, 5, 6}, // 'f'
+    {313, 0, 5, 6}, // 'g'
+    {318, 0, 5, 6}, // 'h'
+    {323, 0, 3, 4}, // 'i'
+    {326, 0, 4, 5}, // 'j'
+    {330, 0, 4, 5}, // 'k'
+    {334, 0, 3, 4}, // 'l'
+    {337, 0, 5, 6}, // 'm'
+    {342, 0, 5, 6}, // 'n'
+    {347, 0, 5, 6}, // 'o'
+    {352, 0, 5, 6}, // 'p'
+    {357, 0, 5, 6}, // 'q'
+    {362, 0, 5, 6}, // 'r'
+    {367, 0, 5, 6}, // 's'
+    {372, 0, 5, 6}, // 't'
+    {377, 0, 5, 6}, // 'u'
+    {382, 0, 5, 6}, // 'v'
+    {387, 0, 5, 6}, // 'w'
+    {392, 0, 5, 6}, // 'x'
+    {397, 0, 5, 6}, // 'y'
+    {402, 0, 5, 6}, // 'z'
+    {407, 0, 3, 4}, // '{'
+    {410, 0, 1, 2}, // '|'
+    {411, 0, 3, 4}, // '}'
+    {414, 0, 5, 6}, // '~'
+};
+
+static constexpr Nokia5110Font prop5x7 = {prop5x7_data, prop5x7_glyphs, 0x20, 0x7E, 6, 8, 0, false};
+
+int main() {
+    Nokia5110 display(p4, p3, p5, p6, p7);
+    display.init(0x2C);
+    display.clear_buffer();
+
+    // the built in font fits 14 characters on a line
+    display.print_string("Fixed width 5x7", 0, 0);
+
+    // the same glyphs with their blank columns trimmed fit more
+    display.set_font(&prop5x7);
+    display.print_string("Proportional 5x7 font", 0, 10);
+
+    // centred, using the width of the text
+    const char *title = "Centred";
+    display.print_string(title, (display.width() - display.text_width(title)) / 2, 24, -1, Nokia5110::pixel_xor);
+
+    display.set_font(NULL);
+    display.display();
+}
@@ -0,0 +1,20 @@
+#include <mbed.h>
+#include <Nokia5110.h>
+
+int main() {
+    Nokia5110 display(p4, p3, p5, p6, p7);
+    display.init(0x2C);
+    display.clear_buffer();
+    display.print_string("Speed", 0, 0);
+    display.print_string("km/h", 60, 0);
+
+    char text[4];
+    for (unsigned int i = 0;; i++) {
+        // the digits are drawn 4x, 32 pixels tall. building with
+        // LCD_SCALE_CACHE=10 keeps every digit scaled after it is first drawn
+        snprintf(text, sizeof(text), "%3u", i % 1000);
+        display.print_scaled(text, 6, 12, 4);
+        display.display_dirty();
+        wait_ms(100);
+    }
+}
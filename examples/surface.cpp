@@ -0,0 +1,29 @@
+#include <mbed.h>
+#include <Nokia5110.h>
+#include <Nokia5110Surface.h>
+
+int main() {
+    Nokia5110 display(p4, p3, p5, p6, p7);
+    display.init(0x2C);
+
+    // draw a button once, off-screen
+    Nokia5110Surface<30, 13> button;
+    button.fill_rrect(0, 0, 29, 12, 3);
+    button.print_string("OK", 9, 3, -1, Nokia5110::pixel_xor);
+
+    display.clear_buffer();
+    display.fill_rect(0, 0, 83, 47, Nokia5110::pattern_ltgrey);
+
+    // and stamp it onto the display wherever it's needed
+    display.blit(button, 0, 0, 29, 12, 4, 4);
+    display.blit(button, 0, 0, 29, 12, 50, 4, Nokia5110::pixel_invt);
+    display.blit(button, 0, 0, 29, 12, 27, 30, Nokia5110::pixel_xor);
+    display.display();
+
+    // blitting within the display scrolls it
+    while (true) {
+        wait_ms(100);
+        display.blit(display, 0, 1, 83, 47, 0, 0);
+        display.display_dirty();
+    }
+}
@@ -0,0 +1,38 @@
+#include <mbed.h>
+#include <Nokia5110Tiled.h>
+
+int main() {
+    // four displays in a square, sharing every pin except CE
+    SPI bus(p6, NC, p7);
+    Nokia5110SPI top_left(bus, p4, p3, p5);
+    Nokia5110SPI top_right(bus, p8, p3, p5);
+    Nokia5110SPI bottom_left(bus, p9, p3, p5);
+    Nokia5110SPI bottom_right(bus, p10, p3, p5);
+    Nokia5110Transport *transports[] = {&top_left, &top_right, &bottom_left, &bottom_right};
+
+    Nokia5110Tiled<2, 2> display(transports);
+    display.init(0x2C);
+    display.clear_buffer();
+    display.draw_rect(0, 0, display.width() - 1, display.height() - 1);
+    display.fill_circle(84, 48, 30, Nokia5110Canvas::pattern_grey);
+    display.print_string("Hello World!", 48, 44, -1, Nokia5110Canvas::pixel_xor);
+    display.display();
+
+    // only the displays the ball crosses are sent each frame
+    uint8_t x = 10, y = 10;
+    int8_t dx = 1, dy = 1;
+    while (true) {
+        display.fill_rect(x, y, x + 3, y + 3, Nokia5110Canvas::pattern_black, Nokia5110Canvas::pixel_xor);
+        x += dx;
+        y += dy;
+        if (x == 1 || x == display.width() - 5) {
+            dx = -dx;
+        }
+        if (y == 1 || y == display.height() - 5) {
+            dy = -dy;
+        }
+        display.fill_rect(x, y, x + 3, y + 3, Nokia5110Canvas::pattern_black, Nokia5110Canvas::pixel_xor);
+        display.display_dirty();
+        wait_ms(20);
+    }
+}
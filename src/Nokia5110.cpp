@@ -16,201 +16,1406 @@
 
 #include "Nokia5110.h"
 #include "isqrt.h"
+#include <new>
+
+// a kernel's instantiations for every Mode, indexed by the Mode
+#define LCD_MODE_TABLE(kernel) { \
+    &Nokia5110Canvas::kernel<Nokia5110Canvas::pixel_copy>, &Nokia5110Canvas::kernel<Nokia5110Canvas::pixel_or>, \
+    &Nokia5110Canvas::kernel<Nokia5110Canvas::pixel_xor>, &Nokia5110Canvas::kernel<Nokia5110Canvas::pixel_clr>, \
+    &Nokia5110Canvas::kernel<Nokia5110Canvas::pixel_invt>, &Nokia5110Canvas::kernel<Nokia5110Canvas::pixel_nor>, \
+    &Nokia5110Canvas::kernel<Nokia5110Canvas::pixel_xnor>, &Nokia5110Canvas::kernel<Nokia5110Canvas::pixel_nclr> \
+}
+
+
+// the documented bound doesn't count the transport
+#ifdef __MBED__
+static_assert(sizeof(Nokia5110) - sizeof(Nokia5110SPI) <= LCD_INSTANCE_BYTES, "LCD_INSTANCE_BYTES is out of date");
+#else
+static_assert(sizeof(Nokia5110) <= LCD_INSTANCE_BYTES, "LCD_INSTANCE_BYTES is out of date");
+#endif
+
+#ifdef __MBED__
+Nokia5110SPIHolder::Nokia5110SPIHolder() {
+    _own_transport = NULL;
+}
+
+Nokia5110SPIHolder::Nokia5110SPIHolder(PinName sce, PinName rst, PinName dc, PinName dn, PinName sclk) {
+    _own_transport = new (_transport_storage) Nokia5110SPI(sce, rst, dc, dn, sclk);
+}
+
+Nokia5110SPIHolder::~Nokia5110SPIHolder() {
+    if (_own_transport) {
+        _own_transport->~Nokia5110SPI();
+    }
+}
+
+Nokia5110::Nokia5110(PinName sce, PinName rst, PinName dc, PinName dn, PinName sclk)
+    : Nokia5110SPIHolder(sce, rst, dc, dn, sclk),
+      Nokia5110Canvas(_frames[0], LCD_WIDTH, LCD_HEIGHT, _dirty_banks[0], _dirty_banks[1], _clip_banks),
+      Nokia5110Panel(*_own_transport, _frames[0]) {
+#if LCD_DOUBLE_BUFFER
+    _front = _frames[1];
+#endif
+}
+#endif
+
+Nokia5110::Nokia5110(Nokia5110Transport &transport)
+    : Nokia5110Canvas(_frames[0], LCD_WIDTH, LCD_HEIGHT, _dirty_banks[0], _dirty_banks[1], _clip_banks),
+      Nokia5110Panel(transport, _frames[0]) {
+#if LCD_DOUBLE_BUFFER
+    _front = _frames[1];
+#endif
+}
+
+Nokia5110::~Nokia5110() {
+#if LCD_DOUBLE_BUFFER
+    wait_flush();
+#endif
+    // the transport, if the pin constructor made one, is destroyed after the
+    // panel by ~Nokia5110SPIHolder()
+}
+
+void Nokia5110::init(uint8_t con, uint8_t bias) {
+    Nokia5110Panel::init(con, bias);
+    set_dirty(true);
+}
+
+void Nokia5110::reset() {
+    Nokia5110Panel::reset();
+    set_dirty(true);
+}
+
+Nokia5110Canvas::Nokia5110Canvas(uint8_t *buffer, uint8_t width, uint8_t height,
+                                 uint8_t *dirty_x0, uint8_t *dirty_x1, uint8_t *clip_rows) {
+    _buffer = buffer;
+    _width = width;
+    _height = height;
+    _banks = (height + 7) / 8;
+    _dirty_x0 = dirty_x0;
+    _dirty_x1 = dirty_x1;
+    _clip_rows = clip_rows;
+    _font = &font_5x7;
+
+#if LCD_STATS
+    _pixels = 0;
+#endif
+    reset_clip();
+    set_dirty(true);
+}
+
+Nokia5110Panel::Nokia5110Panel(Nokia5110Transport &transport, const uint8_t *frame, unsigned int stride) {
+    _transport = &transport;
+    _frame = frame;
+    _stride = stride;
+
+#if LCD_DOUBLE_BUFFER
+    _busy = false;
+#endif
+
+    _cmd_len = 0;
+    forget_state();
+
+#if LCD_STATS
+    reset_stats();
+#endif
+
+#if LCD_SHADOW_BUFFER
+    _shadow_valid = false;
+#endif
+}
+
+Nokia5110Panel::~Nokia5110Panel() {
+#if LCD_DOUBLE_BUFFER
+    wait_flush();
+#endif
+}
+
+void Nokia5110Panel::init(uint8_t con, uint8_t bias) {
+    reset();
+    _transport->delay_ms(10);
+    set_contrast(con);
+    set_bias(bias);
+    set_mode(LCD_DISPLAYNORMAL);
+}
+
+void Nokia5110Panel::reset() {
+    _transport->set_reset(true);
+    _transport->delay_ms(500);
+    _transport->set_reset(false);
+
+    forget_state();
+#if LCD_SHADOW_BUFFER
+    _shadow_valid = false; // the display's RAM is undefined after a reset
+#endif
+}
+
+void Nokia5110Panel::send_command(uint8_t cmd) {
+    queue_command(cmd);
+    flush_commands();
+}
+
+void Nokia5110Panel::send_data(uint8_t data) {
+    send_data(&data, 1);
+}
+
+void Nokia5110Panel::send_data(const uint8_t *data, size_t len) {
+    begin_data();
+    write_data(data, len);
+    end_data(len);
+}
+
+void Nokia5110Panel::begin_data() {
+#if LCD_DOUBLE_BUFFER
+    wait_flush();
+#endif
+    select(true);
+
+    // any queued commands go out in the same CE window, the controller
+    // reads D/C on the last bit of each byte
+    write_commands();
+
+    _transport->set_dc(true);
+}
+
+void Nokia5110Panel::write_data(const uint8_t *data, size_t len) {
+    _transport->write(data, len);
+#if LCD_STATS
+    _stats.data_bytes += len;
+#endif
+}
+
+void Nokia5110Panel::end_data(size_t len) {
+    _transport->set_dc(false);
+
+    select(false);
+
+    advance_cursor(len);
+}
+
+void Nokia5110Panel::flush_commands() {
+    if (!_cmd_len) {
+        return;
+    }
+
+#if LCD_DOUBLE_BUFFER
+    wait_flush();
+#endif
+    select(true);
+    write_commands();
+    select(false);
+}
+
+void Nokia5110Panel::set_contrast(uint8_t con) {
+    if (con > 0x7f) {
+        con = 0x7f;
+    }
+
+    if (con != _vop) {
+        queue_function(function() | LCD_EXTENDEDINSTRUCTION);
+        queue_command(LCD_SETVOP | con);
+        flush_commands();
+    }
+}
+
+void Nokia5110Panel::set_bias(uint8_t bias) {
+    if (bias > 0x07) {
+        bias = 0x07;
+    }
+
+    if (bias != _bias) {
+        queue_function(function() | LCD_EXTENDEDINSTRUCTION);
+        queue_command(LCD_SETBIAS | bias);
+        flush_commands();
+    }
+}
+
+void Nokia5110Panel::set_mode(uint8_t mode) {
+    // only the D and E bits are part of the command
+    if (mode > LCD_DISPLAYINVERTED) {
+        mode = LCD_DISPLAYINVERTED;
+    }
+    mode &= LCD_DISPLAYINVERTED;
+
+    if (mode != _display_mode) {
+        queue_function(function() & ~LCD_EXTENDEDINSTRUCTION);
+        queue_command(LCD_DISPLAYCONTROL | mode);
+        flush_commands();
+    }
+}
+
+void Nokia5110Panel::set_power(uint8_t pow) {
+    pow = pow ? 0 : LCD_POWERDOWN;
+    queue_function((function() & ~LCD_POWERDOWN) | pow);
+    flush_commands();
+}
+
+void Nokia5110Panel::set_column(uint8_t col) {
+    col %= LCD_WIDTH;
+
+    if (col != _x) {
+        queue_function(function() & ~LCD_EXTENDEDINSTRUCTION);
+        queue_command(LCD_SETXADDR | col);
+    }
+}
+
+void Nokia5110Panel::set_bank(uint8_t bank) {
+    bank %= LCD_BANKS;
+
+    if (bank != _bank) {
+        queue_function(function() & ~LCD_EXTENDEDINSTRUCTION);
+        queue_command(LCD_SETYADDR | bank);
+    }
+}
+
+void Nokia5110Panel::set_cursor(uint8_t col, uint8_t bank) {
+    set_column(col);
+    set_bank(bank);
+}
+
+void Nokia5110Canvas::clear_buffer() {
+    for (unsigned int i = 0; i < (unsigned int) _width * _banks; i++) {
+        _buffer[i] = 0x00;
+    }
+
+    set_dirty(true);
+}
+
+void Nokia5110Canvas::scroll_banks(uint8_t bank0, uint8_t bank1, uint8_t count) {
+    bank1 = (bank1 < _banks) ? bank1 : _banks - 1;
+    if (bank0 > bank1) {
+        return;
+    }
+
+    uint8_t banks = bank1 - bank0 + 1;
+    count = (count < banks) ? count : banks;
+
+    // banks are whole rows of the buffer, so the range is one block
+    uint8_t *top = _buffer + bank0 * _width;
+    memmove(top, top + count * _width, (banks - count) * _width);
+    memset(top + (banks - count) * _width, 0x00, count * _width);
+
+    for (uint8_t bank = bank0; bank <= bank1; bank++) {
+        mark_dirty(0, bank);
+        mark_dirty(_width - 1, bank);
+    }
+}
+
+void Nokia5110Canvas::set_clip(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+    if (x0 > x1) {
+        uint8_t tmp = x0;
+        x0 = x1;
+        x1 = tmp;
+    }
+
+    if (y0 > y1) {
+        uint8_t tmp = y0;
+        y0 = y1;
+        y1 = tmp;
+    }
+
+    // a rectangle entirely off the screen clips everything
+    _clip_x0 = x0;
+    _clip_y0 = y0;
+    _clip_x1 = (x1 < _width) ? x1 : _width - 1;
+    _clip_y1 = (y1 < _height) ? y1 : _height - 1;
+
+    for (uint8_t bank = 0; bank < _banks; bank++) {
+        int lo = _clip_y0 - bank * 8;
+        int hi = _clip_y1 - bank * 8;
+
+        if (lo > 7 || hi < 0) {
+            _clip_rows[bank] = 0x00;
+        } else {
+            _clip_rows[bank] = (0xFF << ((lo > 0) ? lo : 0)) & (0xFF >> (7 - ((hi < 7) ? hi : 7)));
+        }
+    }
+}
+
+void Nokia5110Canvas::reset_clip() {
+    set_clip(0, 0, _width - 1, _height - 1);
+}
+
+void Nokia5110::display() {
+    Nokia5110Panel::display();
+    set_dirty(false);
+}
+
+void Nokia5110Panel::display() {
+#if LCD_STATS
+    uint32_t start = _transport->time_us();
+#endif
+
+#if LCD_SHADOW_BUFFER
+    if (_shadow_valid) {
+        display_diff();
+    } else {
+        display_full();
+    }
+#else
+    display_full();
+#endif
+
+#if LCD_STATS
+    record_flush(start);
+#endif
+}
+
+void Nokia5110Panel::display_full() {
+    // one burst for the whole frame, the controller auto-increments the
+    // address so D/C and CE only need to be asserted once
+    send_span(0, LCD_BYTES);
+
+#if LCD_SHADOW_BUFFER
+    _shadow_valid = true;
+#endif
+}
+
+#if LCD_DOUBLE_BUFFER
+bool Nokia5110::display_async(lcd_callback_t done) {
+    if (_busy) {
+        return false;
+    }
+
+    set_addressing(false);
+    set_cursor(0, 0);
+
+    uint8_t *tmp = _front;
+    _front = _buffer;
+    _buffer = tmp;
+    _frame = _buffer;
+    memcpy(_buffer, _front, LCD_BYTES);
+
+    set_dirty(false);
+#if LCD_SHADOW_BUFFER
+    memcpy(_shadow, _front, LCD_BYTES);
+    _shadow_valid = true;
+#endif
+
+    send_async(_front, done);
+    return true;
+}
+
+void Nokia5110Panel::send_async(const uint8_t *frame, lcd_callback_t done) {
+    _flush_callback = done;
+    _busy = true;
+#if LCD_STATS
+    _async_start = _transport->time_us();
+    _stats.data_bytes += LCD_BYTES;
+#endif
+    select(true);
+    write_commands();
+    _transport->set_dc(true);
+
+    _transport->write_async(frame, LCD_BYTES, &Nokia5110Panel::flush_done, this);
+
+    advance_cursor(LCD_BYTES);
+}
+
+bool Nokia5110Panel::busy() {
+    return _busy;
+}
+
+void Nokia5110Panel::flush_done(void *panel) {
+    Nokia5110Panel *self = (Nokia5110Panel *) panel;
+
+    self->_transport->set_dc(false);
+    self->select(false);
+    self->_busy = false;
+#if LCD_STATS
+    self->record_flush(self->_async_start);
+#endif
+
+    if (self->_flush_callback) {
+        self->_flush_callback();
+    }
+}
+#endif
+
+void Nokia5110::display_region(uint8_t x0, uint8_t bank0, uint8_t x1, uint8_t bank1) {
+    x0 %= LCD_WIDTH;
+    x1 %= LCD_WIDTH;
+    bank0 %= LCD_BANKS;
+    bank1 %= LCD_BANKS;
+
+    if (x0 > x1) {
+        uint8_t tmp = x0;
+        x0 = x1;
+        x1 = tmp;
+    }
+
+    if (bank0 > bank1) {
+        uint8_t tmp = bank0;
+        bank0 = bank1;
+        bank1 = tmp;
+    }
+
+    uint8_t span_x0[LCD_BANKS];
+    uint8_t span_x1[LCD_BANKS];
+    for (uint8_t bank = 0; bank < LCD_BANKS; bank++) {
+        bool inside = bank >= bank0 && bank <= bank1;
+        span_x0[bank] = inside ? x0 : LCD_WIDTH - 1;
+        span_x1[bank] = inside ? x1 : 0;
+    }
+
+    display_banks(span_x0, span_x1);
+}
+
+void Nokia5110::display_dirty() {
+    display_banks(_dirty_x0, _dirty_x1);
+    set_dirty(false);
+}
+
+#if LCD_STATS
+const Nokia5110::Stats &Nokia5110::stats() {
+    _stats.pixels = _pixels;
+    return _stats;
+}
+
+void Nokia5110::reset_stats() {
+    Nokia5110Panel::reset_stats();
+    _pixels = 0;
+}
+
+const Nokia5110Panel::Stats &Nokia5110Panel::stats() {
+    return _stats;
+}
+
+void Nokia5110Panel::reset_stats() {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+void Nokia5110Panel::record_flush(uint32_t start) {
+    uint32_t time = _transport->time_us() - start;
+
+    uint8_t bucket = 0;
+    for (uint32_t limit = LCD_STATS_BUCKET_US; time >= limit && bucket < LCD_STATS_BUCKETS - 1; limit *= 2) {
+        bucket++;
+    }
+
+    _stats.flushes++;
+    _stats.flush_us[bucket]++;
+}
+#endif
+
+#if LCD_SHADOW_BUFFER
+void Nokia5110Panel::display_diff() {
+    unsigned int i = 0;
+
+    while (i < LCD_BYTES) {
+        const uint8_t *frame = frame_at(i);
+
+        // skip whole words that haven't changed. a word can't straddle two
+        // banks, they might not be next to each other in the frame
+        uint32_t a, b;
+        if (i % LCD_WIDTH + sizeof(a) <= LCD_WIDTH) {
+            memcpy(&a, frame, sizeof(a));
+            memcpy(&b, _shadow + i, sizeof(b));
+            if (a == b) {
+                i += sizeof(a);
+                continue;
+            }
+        }
+
+        if (*frame == _shadow[i]) {
+            i++;
+            continue;
+        }
+
+        // extend the run until there is a gap too long to be worth resending
+        unsigned int start = i;
+        unsigned int end = i + 1;
+        for (unsigned int j = end; j < LCD_BYTES && j <= end + LCD_DIFF_GAP; j++) {
+            if (*frame_at(j) != _shadow[j]) {
+                end = j + 1;
+            }
+        }
+
+        send_span(start, end - start);
+        i = end;
+    }
+}
+#endif
+
+void Nokia5110Panel::display_banks(const uint8_t *x0, const uint8_t *x1) {
+#if LCD_STATS
+    uint32_t start = _transport->time_us();
+#endif
+
+    send_banks(x0, x1);
+
+#if LCD_STATS
+    record_flush(start);
+#endif
+}
+
+void Nokia5110Panel::send_banks(const uint8_t *x0, const uint8_t *x1) {
+    // bytes needed to send each bank's span with horizontal addressing, and
+    // the bounds of a single burst with vertical addressing
+    unsigned int horizontal = 0;
+    int end = -1;
+    uint8_t col0 = LCD_WIDTH - 1;
+    uint8_t col1 = 0;
+    int8_t bank0 = -1;
+    int8_t bank1 = -1;
+
+    for (uint8_t bank = 0; bank < LCD_BANKS; bank++) {
+        if (x0[bank] > x1[bank]) {
+            continue;
+        }
+
+        int start = x0[bank] + bank * LCD_WIDTH;
+        horizontal += x1[bank] - x0[bank] + 1;
+        if (start != end) {
+            horizontal += 2; // SETXADDR and SETYADDR
+        }
+        end = x1[bank] + bank * LCD_WIDTH + 1;
+
+        col0 = (x0[bank] < col0) ? x0[bank] : col0;
+        col1 = (x1[bank] > col1) ? x1[bank] : col1;
+        if (bank0 < 0) {
+            bank0 = bank;
+        }
+        bank1 = bank;
+    }
+
+    if (bank0 < 0) {
+        return; // nothing to send
+    }
+
+    // in vertical addressing the address runs down each column, so the
+    // burst covers every bank between the first and last column
+    unsigned int first = col0 * LCD_BANKS + bank0;
+    unsigned int last = col1 * LCD_BANKS + bank1;
+    unsigned int vertical = last - first + 1 + 2;
+
+    // switching addressing mode costs a FUNCTIONSET
+    if (function() & LCD_ENTRYMODE) {
+        horizontal++;
+    } else {
+        vertical++;
+    }
+
+    if (vertical < horizontal) {
+        send_column_span(first, last - first + 1);
+        return;
+    }
+
+    for (uint8_t bank = 0; bank < LCD_BANKS; bank++) {
+        if (x0[bank] <= x1[bank]) {
+            send_span(x0[bank] + bank * LCD_WIDTH, x1[bank] - x0[bank] + 1);
+        }
+    }
+}
+
+void Nokia5110Panel::send_column_span(unsigned int start, unsigned int len) {
+    set_addressing(true);
+    set_cursor(start / LCD_BANKS, start % LCD_BANKS);
+
+    begin_data();
+
+    // gather the bytes into column order a few columns at a time
+    uint8_t chunk[LCD_BANKS * 8];
+    unsigned int addr = start;
+    while (addr < start + len) {
+        unsigned int n = 0;
+        while (n < sizeof(chunk) && addr < start + len) {
+            chunk[n] = _frame[(addr % LCD_BANKS) * _stride + addr / LCD_BANKS];
+#if LCD_SHADOW_BUFFER
+            _shadow[(addr % LCD_BANKS) * LCD_WIDTH + addr / LCD_BANKS] = chunk[n];
+#endif
+            n++;
+            addr++;
+        }
+
+        write_data(chunk, n);
+    }
+
+    end_data(len);
+}
+
+void Nokia5110Panel::send_span(unsigned int start, unsigned int len) {
+    // set_cursor() drops the commands if the address already auto-incremented
+    // to the start of the span
+    set_addressing(false);
+    set_cursor(start % LCD_WIDTH, start / LCD_WIDTH);
+
+    // the window's banks are only next to each other in the frame if it's
+    // as wide as the display, otherwise each bank's part of the span is
+    // written separately. the controller moves on to the next bank by
+    // itself, so it's still one CE window
+    begin_data();
+    for (unsigned int addr = start; addr < start + len;) {
+        unsigned int n = start + len - addr;
+        if (_stride != LCD_WIDTH && n > LCD_WIDTH - addr % LCD_WIDTH) {
+            n = LCD_WIDTH - addr % LCD_WIDTH;
+        }
+
+        write_data(frame_at(addr), n);
+#if LCD_SHADOW_BUFFER
+        memcpy(_shadow + addr, frame_at(addr), n);
+#endif
+        addr += n;
+    }
+    end_data(len);
+}
+
+void Nokia5110Panel::queue_command(uint8_t cmd) {
+    if (_cmd_len == sizeof(_cmd_queue)) {
+        flush_commands();
+    }
+
+    _cmd_queue[_cmd_len++] = cmd;
+
+    // keep track of what the command does to the controller
+    if ((cmd & 0xF8) == LCD_FUNCTIONSET) {
+        _function = cmd & 0x07;
+    } else if (_function == LCD_STATE_UNKNOWN) {
+        forget_state(); // cant tell which instruction set this is from
+    } else if (_function & LCD_EXTENDEDINSTRUCTION) {
+        if (cmd & LCD_SETVOP) {
+            _vop = cmd & 0x7F;
+        } else if ((cmd & 0xF8) == LCD_SETBIAS) {
+            _bias = cmd & 0x07;
+        }
+    } else {
+        if (cmd & LCD_SETXADDR) {
+            _x = cmd & 0x7F;
+        } else if ((cmd & 0xF8) == LCD_SETYADDR) {
+            _bank = cmd & 0x07;
+        } else if ((cmd & 0xF8) == LCD_DISPLAYCONTROL) {
+            _display_mode = cmd & 0x07;
+        }
+    }
+}
+
+void Nokia5110Panel::queue_function(uint8_t function) {
+    if (function != _function) {
+        queue_command(LCD_FUNCTIONSET | function);
+    }
+}
+
+void Nokia5110Panel::write_commands() {
+    if (_cmd_len) {
+        _transport->write(_cmd_queue, _cmd_len);
+#if LCD_STATS
+        _stats.command_bytes += _cmd_len;
+#endif
+        _cmd_len = 0;
+    }
+}
+
+void Nokia5110Panel::advance_cursor(size_t len) {
+    if (_x == LCD_STATE_UNKNOWN || _bank == LCD_STATE_UNKNOWN) {
+        return;
+    }
+
+    if (function() & LCD_ENTRYMODE) {
+        unsigned int addr = (_x * LCD_BANKS + _bank + len) % LCD_BYTES;
+        _x = addr / LCD_BANKS;
+        _bank = addr % LCD_BANKS;
+    } else {
+        unsigned int addr = (_x + _bank * LCD_WIDTH + len) % LCD_BYTES;
+        _x = addr % LCD_WIDTH;
+        _bank = addr / LCD_WIDTH;
+    }
+}
+
+void Nokia5110Panel::set_addressing(bool vertical) {
+    uint8_t function = this->function() & ~(LCD_ENTRYMODE | LCD_EXTENDEDINSTRUCTION);
+    queue_function(function | (vertical ? LCD_ENTRYMODE : 0));
+}
+
+void Nokia5110Panel::forget_state() {
+    _function = LCD_STATE_UNKNOWN;
+    _x = LCD_STATE_UNKNOWN;
+    _bank = LCD_STATE_UNKNOWN;
+    _display_mode = LCD_STATE_UNKNOWN;
+    _vop = LCD_STATE_UNKNOWN;
+    _bias = LCD_STATE_UNKNOWN;
+}
+
+void Nokia5110Canvas::set_dirty(bool dirty) {
+    for (uint8_t bank = 0; bank < _banks; bank++) {
+        _dirty_x0[bank] = dirty ? 0 : _width - 1;
+        _dirty_x1[bank] = dirty ? _width - 1 : 0;
+    }
+}
+
+void Nokia5110Canvas::draw_pixel(uint8_t x, uint8_t y, const pattern_t pattern, Mode mode) {
+    bool value = pattern[y % 8] & (1 << (x % 8)); // I am going to hell
+    draw_pixel(x, y, value, mode);
+}
+
+void Nokia5110Canvas::draw_pixel(uint8_t x, uint8_t y, const Pattern &pattern, Mode mode) {
+    // a shape anchored pattern starts at the pixel itself
+    bool value = (pattern.anchor == Pattern::shape) ? (pattern.columns[0] & 1)
+                                                     : (pattern.columns[x % 8] & (1 << (y % 8)));
+    draw_pixel(x, y, value, mode);
+}
+
+void Nokia5110Canvas::draw_pixel(uint8_t x, uint8_t y, bool value, Mode mode) {
+#if LCD_STATS
+    _pixels++;
+#endif
+
+    if (mode & 0x4) {
+        mode = (Mode) (mode & 0x3);
+        value = !value;
+    }
+
+    if (mode == pixel_copy) {
+        mode = value ? pixel_or : pixel_clr;
+        value = true;
+    }
+
+#if LCD_WRAPAROUND
+    x %= _width;
+    y %= _height;
+#else
+    if (x < _clip_x0 || x > _clip_x1 || y < _clip_y0 || y > _clip_y1) {
+        return;
+    }
+#endif
+
+    if (value) {
+        mark_dirty(x, y / 8);
+
+        switch (mode) {
+        default:
+        case pixel_or:
+            _buffer[x + (y / 8) * _width] |= (1 << (y % 8));
+            break;
+        case pixel_xor:
+            _buffer[x + (y / 8) * _width] ^= (1 << (y % 8));
+            break;
+        case pixel_clr:
+            _buffer[x + (y / 8) * _width] &= ~(1 << (y % 8));
+            break;
+        }
+    }
+}
+
+void Nokia5110Canvas::apply_byte(uint8_t col, uint8_t bank, uint8_t mask, uint8_t bits, Mode mode) {
+    if (mode & 0x4) {
+        mode = (Mode) (mode & 0x3);
+        bits = ~bits;
+    }
+
+    uint8_t &byte = _buffer[col + bank * _width];
+    bits &= mask;
+
+    switch (mode) {
+    default:
+    case pixel_copy:
+        byte = (byte & ~mask) | bits;
+        break;
+    case pixel_or:
+        byte |= bits;
+        break;
+    case pixel_xor:
+        byte ^= bits;
+        break;
+    case pixel_clr:
+        byte &= ~bits;
+        break;
+    }
+
+    mark_dirty(col, bank);
+}
+
+template <Nokia5110Canvas::Mode M>
+void Nokia5110Canvas::draw_pixel(uint8_t x, uint8_t y, bool value) {
+#if LCD_STATS
+    _pixels++;
+#endif
+
+#if LCD_WRAPAROUND
+    x %= _width;
+    y %= _height;
+#else
+    if (x < _clip_x0 || x > _clip_x1 || y < _clip_y0 || y > _clip_y1) {
+        return;
+    }
+#endif
+
+    combine<M>(_buffer[x + (y / 8) * _width], 1 << (y % 8), value ? 0xFF : 0x00);
+    mark_dirty(x, y / 8);
+}
+
+template <Nokia5110Canvas::Mode M>
+void Nokia5110Canvas::apply_byte(uint8_t col, uint8_t bank, uint8_t mask, uint8_t bits) {
+    combine<M>(_buffer[col + bank * _width], mask, bits);
+    mark_dirty(col, bank);
+}
+
+template <Nokia5110Canvas::Mode M>
+inline void Nokia5110Canvas::combine(uint8_t &byte, uint8_t mask, uint8_t bits) {
+    // M is a constant, so everything but one operation is compiled out
+    if (M & 0x4) {
+        bits = ~bits;
+    }
+    bits &= mask;
+
+    switch (M & 0x3) {
+    default:
+    case pixel_copy:
+        byte = (byte & ~mask) | bits;
+        break;
+    case pixel_or:
+        byte |= bits;
+        break;
+    case pixel_xor:
+        byte ^= bits;
+        break;
+    case pixel_clr:
+        byte &= ~bits;
+        break;
+    }
+}
+
+bool Nokia5110Canvas::read_varint(lcd_read_t read, void *ctx, uint32_t *value) {
+    uint8_t byte;
+
+    *value = 0;
+    do {
+        if (read(ctx, &byte, 1) != 1 || (*value >> 24)) { // keep it below 2^31
+            return false;
+        }
+        *value = (*value << 7) | (byte & 0x7F);
+    } while (byte & 0x80); // the top bit is set on all but the last byte
+
+    return true;
+}
+
+bool Nokia5110Canvas::skip_extensions(lcd_read_t read, void *ctx, uint8_t fix) {
+    uint8_t byte = fix;
+
+    while (byte & 0x80) { // another extension header follows
+        if ((fix & 0x60) == 0x60) {
+            // parameter/value pairs, with their lengths packed into one byte
+            if (read(ctx, &byte, 1) != 1) {
+                return false;
+            }
+            size_t len = ((byte >> 4) & 0x07) + (byte & 0x0F);
+            if (read(ctx, NULL, len) != len) {
+                return false;
+            }
+        } else if (read(ctx, &byte, 1) != 1) { // multi-byte bitfield
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t Nokia5110Canvas::read_memory(void *ctx, uint8_t *buf, size_t len) {
+    const uint8_t **data = (const uint8_t **) ctx;
+
+    if (buf) {
+        memcpy(buf, *data, len);
+    }
+    *data += len;
+
+    return len;
+}
+
+size_t Nokia5110Canvas::read_file(void *ctx, uint8_t *buf, size_t len) {
+    FILE *file = (FILE *) ctx;
+
+    if (buf) {
+        return fread(buf, 1, len, file);
+    }
+
+    return fseek(file, (long) len, SEEK_CUR) ? 0 : len;
+}
+
+void Nokia5110Canvas::draw_column_byte(int16_t col, int16_t y, uint8_t mask, uint8_t bits, Mode mode) {
+#if !LCD_WRAPAROUND
+    if (col < _clip_x0 || col > _clip_x1 || y > _clip_y1 || y + 7 < _clip_y0) {
+        return;
+    }
+#endif
+
+    uint8_t bank = y / 8;
+    uint8_t shift = y % 8;
+    uint8_t low = mask << shift;
+
+#if !LCD_WRAPAROUND
+    low &= _clip_rows[bank];
+#endif
+    if (low) {
+        apply_byte(col, bank, low, bits << shift, mode);
+    }
+
+    if (shift) {
+        uint8_t high = mask >> (8 - shift);
+
+#if LCD_WRAPAROUND
+        bank = (bank + 1) % _banks;
+#else
+        bank++;
+        high = (bank < _banks) ? (high & _clip_rows[bank]) : 0x00;
+#endif
+        if (high) {
+            apply_byte(col, bank, high, bits >> (8 - shift), mode);
+        }
+    }
+}
+
+Nokia5110Canvas::Pattern Nokia5110Canvas::Pattern::anchored(uint8_t x, uint8_t y) const {
+    if (anchor == screen) {
+        return *this;
+    }
+
+    // shift the columns so the pattern's origin lands on (x, y)
+    Pattern pattern = *this;
+    pattern.anchor = screen;
+    for (uint8_t i = 0; i < 8; i++) {
+        pattern.columns[(x + i) % 8] = (columns[i] << (y % 8)) | (columns[i] >> ((8 - y % 8) % 8));
+    }
+
+    return pattern;
+}
+
+void Nokia5110Canvas::clip_pixel(int16_t x, int16_t y, const Pattern &pattern, Mode mode) {
+#if !LCD_WRAPAROUND
+    if (x < _clip_x0 || x > _clip_x1 || y < _clip_y0 || y > _clip_y1) {
+        return;
+    }
+#endif
+    draw_pixel(x, y, pattern, mode);
+}
+
+void Nokia5110Canvas::clip_pixel(int16_t x, int16_t y, bool value, Mode mode) {
+#if !LCD_WRAPAROUND
+    if (x < _clip_x0 || x > _clip_x1 || y < _clip_y0 || y > _clip_y1) {
+        return;
+    }
+#endif
+    draw_pixel(x, y, value, mode);
+}
+
+void Nokia5110Canvas::clip_hline(int16_t x0, int16_t x1, int16_t y, const Pattern &pattern, Mode mode) {
+#if !LCD_WRAPAROUND
+    if (x0 > x1) {
+        int16_t tmp = x0;
+        x0 = x1;
+        x1 = tmp;
+    }
+
+    if (y < _clip_y0 || y > _clip_y1 || x1 < _clip_x0 || x0 > _clip_x1) {
+        return;
+    }
+    x0 = (x0 > _clip_x0) ? x0 : _clip_x0;
+    x1 = (x1 < _clip_x1) ? x1 : _clip_x1;
+#endif
+    draw_hline(x0, x1, y, pattern, mode);
+}
+
+void Nokia5110Canvas::clip_vline(int16_t y0, int16_t y1, int16_t x, const Pattern &pattern, Mode mode) {
+#if !LCD_WRAPAROUND
+    if (y0 > y1) {
+        int16_t tmp = y0;
+        y0 = y1;
+        y1 = tmp;
+    }
+
+    if (x < _clip_x0 || x > _clip_x1 || y1 < _clip_y0 || y0 > _clip_y1) {
+        return;
+    }
+    y0 = (y0 > _clip_y0) ? y0 : _clip_y0;
+    y1 = (y1 < _clip_y1) ? y1 : _clip_y1;
+#endif
+    draw_vline(y0, y1, x, pattern, mode);
+}
 
+void Nokia5110Canvas::clip_fill_rect(int16_t x0, int16_t y0, int16_t x1, int16_t y1, const Pattern &pattern, Mode mode) {
+#if !LCD_WRAPAROUND
+    if (x0 > x1) {
+        int16_t tmp = x0;
+        x0 = x1;
+        x1 = tmp;
+    }
 
-Nokia5110::Nokia5110(PinName sce, PinName rst, PinName dc, PinName dn, PinName sclk) {
-    _lcd_SPI = new SPI(dn, NC, sclk);
-    _lcd_SPI->format(LCD_SPI_BITS, LCD_SPI_MODE);
-    _lcd_SPI->frequency(LCD_SPI_FREQ);
+    if (y0 > y1) {
+        int16_t tmp = y0;
+        y0 = y1;
+        y1 = tmp;
+    }
 
-    _sce = new DigitalOut(sce, 1);
-    _rst = new DigitalOut(rst, 1);
-    _dc = new DigitalOut(dc, 0);
+    if (x1 < _clip_x0 || x0 > _clip_x1 || y1 < _clip_y0 || y0 > _clip_y1) {
+        return;
+    }
+    x0 = (x0 > _clip_x0) ? x0 : _clip_x0;
+    y0 = (y0 > _clip_y0) ? y0 : _clip_y0;
+    x1 = (x1 < _clip_x1) ? x1 : _clip_x1;
+    y1 = (y1 < _clip_y1) ? y1 : _clip_y1;
+#endif
+    fill_rect(x0, y0, x1, y1, pattern, mode);
 }
 
-void Nokia5110::init(uint8_t con, uint8_t bias) {
-    reset();
-    wait_ms(10);
-    set_contrast(con);
-    set_bias(bias);
-    set_mode(LCD_DISPLAYNORMAL);
-}
+bool Nokia5110Canvas::clip_line(int16_t a0, int8_t sa, int16_t lo_a, int16_t hi_a,
+                          int16_t b0, int8_t sb, int16_t lo_b, int16_t hi_b,
+                          int16_t major, int16_t minor, unsigned int *first, unsigned int *last) {
+    // steps that are inside the rectangle on the major axis
+    int32_t i0 = (sa > 0) ? lo_a - a0 : a0 - hi_a;
+    int32_t i1 = (sa > 0) ? hi_a - a0 : a0 - lo_a;
 
-void Nokia5110::reset() {
-    _rst->write(0);
-    wait_ms(500);
-    _rst->write(1);
-}
+    // offsets that are inside the rectangle on the minor axis
+    int32_t m0 = (sb > 0) ? lo_b - b0 : b0 - hi_b;
+    int32_t m1 = (sb > 0) ? hi_b - b0 : b0 - lo_b;
+
+    if (m1 < 0 || m0 > minor) {
+        return false;
+    }
 
-void Nokia5110::send_command(uint8_t cmd) {
-    _sce->write(0);
+    // the offset only grows, so the steps with offsets from m0 to m1 are a
+    // range too. first step with an offset of at least m0:
+    if (m0 > 0) {
+        int32_t i = (m0 * major + minor) / minor - 1;
+        i0 = (i > i0) ? i : i0;
+    }
+    // last step with an offset of at most m1:
+    if (m1 < minor) {
+        int32_t i = (m1 + 1) * major / minor - 1;
+        i1 = (i < i1) ? i : i1;
+    }
 
-    _lcd_SPI->write(cmd);
+    i0 = (i0 > 0) ? i0 : 0;
+    i1 = (i1 < major) ? i1 : major;
+    if (i0 > i1) {
+        return false;
+    }
 
-    _sce->write(1);
+    *first = i0;
+    *last = i1;
+    return true;
 }
 
-void Nokia5110::send_data(uint8_t data) {
-    _dc->write(1);
-    _sce->write(0);
+uint8_t Nokia5110Canvas::column_spans(unsigned int y0, unsigned int y1, uint8_t *banks, uint8_t *masks) {
+    uint8_t spans = 0;
 
-    _lcd_SPI->write(data);
+    // the height is a multiple of 8 if coordinates wrap (Nokia5110Surface
+    // checks it, the other canvases are whole displays), so a row's bit in
+    // its bank is the same before and after wrapping
+    for (unsigned int y = y0; y <= y1;) {
+        unsigned int end = y | 0x7; // last row in the same bank
+        if (end > y1) {
+            end = y1;
+        }
 
-    _sce->write(1);
-    _dc->write(0);
-}
+        banks[spans] = wrap_y(y) / 8;
+        masks[spans] = ((1 << (end - y + 1)) - 1) << (y % 8);
+        spans++;
 
-void Nokia5110::set_contrast(uint8_t con) {
-    if (con > 0x7f) {
-        con = 0x7f;
+        y = end + 1;
     }
 
-    send_command(LCD_FUNCTIONSET | LCD_EXTENDEDINSTRUCTION);
-    send_command(LCD_SETVOP | con);
-    send_command(LCD_FUNCTIONSET);
+    return spans;
 }
 
-void Nokia5110::set_bias(uint8_t bias) {
-    if (bias > 0x08) {
-        bias = 0x08;
-    }
+uint8_t Nokia5110Canvas::get_pixel(uint8_t x, uint8_t y) {
+    x %= _width;
+    y %= _height;
 
-    send_command(LCD_FUNCTIONSET | LCD_EXTENDEDINSTRUCTION);
-    send_command(LCD_SETBIAS | bias);
-    send_command(LCD_FUNCTIONSET);
+    return _buffer[x + (y / 8) * _width] & (1 << (y % 8));
 }
 
-void Nokia5110::set_mode(uint8_t mode) {
-    if (mode > 0x08) {
-        mode = 0x08;
-    }
+void Nokia5110Canvas::draw_byte(uint8_t col, uint8_t bank, uint8_t byte) {
+    col %= _width;
+    bank %= _banks;
 
-    send_command(LCD_DISPLAYCONTROL | mode);
+    _buffer[col + bank * _width] = byte;
+    mark_dirty(col, bank);
 }
 
-void Nokia5110::set_power(uint8_t pow) {
-    pow = pow ? 0 : LCD_POWERDOWN;
-    send_command(LCD_FUNCTIONSET | pow);
-}
+uint8_t Nokia5110Canvas::get_byte(uint8_t col, uint8_t bank) {
+    col %= _width;
+    bank %= _banks;
 
-void Nokia5110::set_column(uint8_t col) {
-    col %= LCD_WIDTH;
-    send_command(LCD_SETXADDR | col);
+    return _buffer[col + bank * _width];
 }
 
-void Nokia5110::set_bank(uint8_t bank) {
-    bank %= LCD_BANKS;
-    send_command(LCD_SETYADDR | bank);
+void Nokia5110Canvas::set_font(const Nokia5110Font *font) {
+    _font = font ? font : &font_5x7;
 }
 
-void Nokia5110::set_cursor(uint8_t col, uint8_t bank) {
-    set_column(col);
-    set_bank(bank);
-}
+Nokia5110Glyph Nokia5110Canvas::find_glyph(char c) const {
+    uint8_t index = (uint8_t) c;
+    index = (index >= _font->first && index <= _font->last) ? index - _font->first : 0;
 
-void Nokia5110::clear_buffer() {
-    for (unsigned int i = 0; i < LCD_BYTES; i++) {
-        _buffer[i] = 0x00;
+    if (_font->glyphs) {
+        return _font->glyphs[index];
     }
+
+    Nokia5110Glyph glyph;
+    glyph.offset = index * _font->width * ((_font->height + 7) / 8);
+    glyph.left = 0;
+    glyph.width = _font->width;
+    glyph.advance = _font->width;
+    return glyph;
 }
 
-void Nokia5110::display() {
-    set_bank(0);
-    set_column(0);
-    for (unsigned int i = 0; i < LCD_BYTES; i++) {
-        send_data(_buffer[i]);
+unsigned int Nokia5110Canvas::text_width(const char *str, int8_t chars) const {
+    unsigned int width = 0;
+
+    while (*str && chars-- != 0) {
+        width += find_glyph(*str).advance + _font->spacing;
+        str++;
     }
+
+    return width;
 }
 
-void Nokia5110::draw_pixel(uint8_t x, uint8_t y, const pattern_t pattern, Mode mode) {
-    bool value = pattern[y % 8] & (1 << (x % 8)); // I am going to hell
-    draw_pixel(x, y, value, mode);
+uint8_t Nokia5110Canvas::print_char(char c, uint8_t x, uint8_t y, Mode mode) {
+#if LCD_WRAPAROUND
+    x %= _width;
+    y %= _height;
+#endif
+
+    static void (Nokia5110Canvas::*const kernels[8])(const uint8_t *, bool, const Nokia5110Glyph &, uint8_t, uint8_t, uint8_t) = LCD_MODE_TABLE(draw_glyph);
+    const Nokia5110Glyph glyph = find_glyph(c);
+    (this->*kernels[mode & 0x7])(_font->data + glyph.offset, _font->rle, glyph, _font->height, x, y);
+
+    return x + glyph.advance + _font->spacing;
 }
 
-void Nokia5110::draw_pixel(uint8_t x, uint8_t y, bool value, Mode mode) {
-    if (mode & 0x4) {
-        mode = (Mode) (mode & 0x3);
-        value = !value;
-    }
+uint8_t Nokia5110Canvas::print_string(const char *str, uint8_t x, uint8_t y, int8_t chars, Mode mode) {
+    static void (Nokia5110Canvas::*const kernels[8])(const uint8_t *, bool, const Nokia5110Glyph &, uint8_t, uint8_t, uint8_t) = LCD_MODE_TABLE(draw_glyph);
+    void (Nokia5110Canvas::*const kernel)(const uint8_t *, bool, const Nokia5110Glyph &, uint8_t, uint8_t, uint8_t) = kernels[mode & 0x7];
 
-    if (mode == pixel_copy) {
-        mode = value ? pixel_or : pixel_clr;
-        value = true;
-    }
+    x %= _width;
+    y %= _height;
 
-    if (value) {
-        x %= LCD_WIDTH;
-        y %= LCD_HEIGHT;
+    while (*str && chars-- != 0) {
+        const Nokia5110Glyph glyph = find_glyph(*str);
 
-        switch (mode) {
-        default:
-        case pixel_or:
-            _buffer[x + (y / 8) * LCD_WIDTH] |= (1 << (y % 8));
-            break;
-        case pixel_xor:
-            _buffer[x + (y / 8) * LCD_WIDTH] ^= (1 << (y % 8));
-            break;
-        case pixel_clr:
-            _buffer[x + (y / 8) * LCD_WIDTH] &= ~(1 << (y % 8));
+        if (x + glyph.advance + _font->spacing > _width) {
             break;
         }
+
+        (this->*kernel)(_font->data + glyph.offset, _font->rle, glyph, _font->height, x, y);
+        x += glyph.advance + _font->spacing;
+        str++;
     }
+
+    return x;
 }
 
-uint8_t Nokia5110::get_pixel(uint8_t x, uint8_t y) {
-    x %= LCD_WIDTH;
-    y %= LCD_HEIGHT;
+uint8_t Nokia5110Canvas::print_scaled(const char *str, uint8_t x, uint8_t y, uint8_t scale, Mode mode) {
+    if (scale <= 1) {
+        return print_string(str, x, y, -1, mode);
+    }
+    if (scale > 4) {
+        scale = 4;
+    }
 
-    return _buffer[x + (y / 8) * LCD_WIDTH] & (1 << (y % 8));
-}
+    const uint8_t banks = (_font->height + 7) / 8;
+#if !LCD_REFERENCE_RASTER
+    static void (Nokia5110Canvas::*const kernels[8])(const uint8_t *, bool, const Nokia5110Glyph &, uint8_t, uint8_t, uint8_t) = LCD_MODE_TABLE(draw_glyph);
+    const unsigned int height = _font->height * scale;
+#if LCD_SCALE_CACHE
+    uint8_t *scratch = NULL;
+#else
+    uint8_t scratch[LCD_SCALE_BYTES];
+#endif
+#endif
 
-void Nokia5110::draw_byte(uint8_t col, uint8_t bank, uint8_t byte) {
-    col %= LCD_WIDTH;
-    bank %= LCD_BANKS;
+    x %= _width;
+    y %= _height;
+
+    while (*str) {
+        const Nokia5110Glyph glyph = find_glyph(*str);
+
+        if (x + (glyph.advance + _font->spacing) * scale > _width) {
+            break;
+        }
+
+#if !LCD_REFERENCE_RASTER
+        if (glyph.width * banks * scale * scale <= LCD_SCALE_BYTES && height <= 0xFF) {
+            Nokia5110Glyph scaled;
+            scaled.offset = 0;
+            scaled.left = glyph.left * scale;
+            scaled.width = glyph.width * scale;
+            scaled.advance = glyph.advance * scale;
+            (this->*kernels[mode & 0x7])(find_scaled(*str, glyph, scale, scratch), false, scaled, height, x, y);
+        } else
+#endif
+        {
+            Nokia5110GlyphReader reader(_font->data + glyph.offset, _font->rle);
+
+            for (unsigned int b = 0; b < banks; b++) {
+                for (unsigned int i = 0; i < glyph.advance; i++) {
+                    uint8_t bits = (i - glyph.left < glyph.width) ? reader.next() : 0x00;
+
+                    for (unsigned int r = 0; r < 8 && b * 8 + r < _font->height; r++) {
+                        for (unsigned int dy = 0; dy < scale; dy++) {
+                            for (unsigned int dx = 0; dx < scale; dx++) {
+                                clip_pixel(x + i * scale + dx, y + (b * 8 + r) * scale + dy, (bool) (bits & (1 << r)), mode);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        x += (glyph.advance + _font->spacing) * scale;
+        str++;
+    }
 
-    _buffer[col + bank * LCD_WIDTH] = byte;
+    return x;
 }
 
-uint8_t Nokia5110::get_byte(uint8_t col, uint8_t bank) {
-    col %= LCD_WIDTH;
-    bank %= LCD_BANKS;
+void Nokia5110Canvas::scale_glyph(const Nokia5110Glyph &glyph, uint8_t scale, uint8_t *out) const {
+    const uint8_t banks = (_font->height + 7) / 8;
+    const unsigned int width = glyph.width * scale; // columns of the scaled glyph
+    const uint16_t *table = spread[scale - 2];
+    Nokia5110GlyphReader reader(_font->data + glyph.offset, _font->rle);
+
+    for (unsigned int b = 0; b < banks; b++) {
+        // the 8 rows of a source bank become 8 * scale rows, exactly scale
+        // banks, so every source byte lands in the same place in them
+        uint8_t *row = out + b * scale * width;
 
-    return _buffer[col + bank * LCD_WIDTH];
+        for (unsigned int i = 0; i < glyph.width; i++) {
+            uint8_t bits = reader.next();
+            uint32_t rows = table[bits & 0xF] | ((uint32_t) table[bits >> 4] << (4 * scale));
+
+            for (unsigned int k = 0; k < scale; k++) {
+                uint8_t byte = rows >> (8 * k);
+
+                for (unsigned int dx = 0; dx < scale; dx++) {
+                    row[k * width + i * scale + dx] = byte;
+                }
+            }
+        }
+    }
 }
 
-uint8_t Nokia5110::print_char(char c, uint8_t x, uint8_t y, Mode mode) {
-    x %= LCD_WIDTH;
-    y %= LCD_HEIGHT;
+const uint8_t *Nokia5110Canvas::find_scaled(char c, const Nokia5110Glyph &glyph, uint8_t scale, uint8_t *scratch) {
+#if LCD_SCALE_CACHE
+    (void) scratch;
+    ScaledGlyph *oldest = &_scale_cache[0];
+    _scale_clock++;
 
-    c -= 32;
+    for (unsigned int i = 0; i < LCD_SCALE_CACHE; i++) {
+        ScaledGlyph &entry = _scale_cache[i];
 
-    for (unsigned int i = 0; i < 5; i++) {
-        for (unsigned int b = 0; b < 8; b++) {
-            draw_pixel(x + i, y + b, font[(5 * c) + i] & (1 << b), mode);
+        if (entry.font == _font && entry.c == c && entry.scale == scale) {
+            entry.used = _scale_clock;
+            return entry.data;
+        }
+        if (entry.used < oldest->used) {
+            oldest = &entry;
         }
     }
 
-    return x + 6;
+    scale_glyph(glyph, scale, oldest->data);
+    oldest->font = _font;
+    oldest->c = c;
+    oldest->scale = scale;
+    oldest->used = _scale_clock;
+    return oldest->data;
+#else
+    (void) c;
+    scale_glyph(glyph, scale, scratch);
+    return scratch;
+#endif
 }
 
-uint8_t Nokia5110::print_string(const char *str, uint8_t x, uint8_t y, int8_t chars, Mode mode) {
-    x %= LCD_WIDTH;
-    y %= LCD_HEIGHT;
+template <Nokia5110Canvas::Mode M>
+void Nokia5110Canvas::draw_glyph(const uint8_t *data, bool rle, const Nokia5110Glyph &glyph, uint8_t height,
+                                 uint8_t x, uint8_t y) {
+    const uint8_t banks = (height + 7) / 8;
+    const uint8_t last_rows = height - (banks - 1) * 8; // rows in the glyph's last bank
+    Nokia5110GlyphReader reader(data, rle);
+
+#if !LCD_REFERENCE_RASTER && !LCD_WRAPAROUND
+    // columns of the cell inside the clip rectangle
+    int16_t i0 = (_clip_x0 > x) ? _clip_x0 - x : 0;
+    int16_t i1 = (_clip_x1 - x + 1 < glyph.advance) ? _clip_x1 - x + 1 : glyph.advance;
+#endif
+
+    for (unsigned int b = 0; b < banks; b++) {
+        uint8_t rows = (b + 1u == banks) ? last_rows : 8;
+
+#if LCD_REFERENCE_RASTER || LCD_WRAPAROUND
+        for (unsigned int i = 0; i < glyph.advance; i++) {
+            // the blank columns either side of a proportional glyph aren't
+            // stored
+            uint8_t bits = (i - glyph.left < glyph.width) ? reader.next() : 0x00;
+
+#if LCD_REFERENCE_RASTER
+            for (unsigned int r = 0; r < rows; r++) {
+                clip_pixel(x + i, y + b * 8 + r, (bool) (bits & (1 << r)), M);
+            }
+#else
+            draw_column_byte((x + i) % _width, (y + b * 8) % _height, 0xFF >> (8 - rows), bits, M);
+#endif
+        }
+#else
+        // the font is stored as column bytes, the same layout as the banks,
+        // so each column is combined into one byte if the glyph is aligned
+        // to a bank and two otherwise. the clip rectangle is applied to the
+        // masks once for the whole row of bytes
+        unsigned int top = y + b * 8;
+        uint8_t bank = top / 8;
+        uint8_t shift = top % 8;
+        uint8_t mask = 0xFF >> (8 - rows);
+        uint8_t low = 0x00;
+        uint8_t high = 0x00;
+
+        if (top <= _clip_y1 && top + 7 >= _clip_y0) {
+            low = (uint8_t) (mask << shift) & _clip_rows[bank];
+            if (shift && bank + 1 < _banks) {
+                high = (mask >> (8 - shift)) & _clip_rows[bank + 1];
+            }
+        }
+
+        if (!(low | high) || i0 >= i1) {
+            // the rest of the glyph might be visible, so the bytes still have
+            // to be read past
+            for (unsigned int i = 0; i < glyph.width; i++) {
+                reader.next();
+            }
+            continue;
+        }
 
-    while (*str && x + 6 <= LCD_WIDTH && chars-- != 0) {
-        x = print_char(*str, x, y, mode);
-        str++;
-    }
+        uint8_t *row = _buffer + bank * _width + x;
 
-    return x;
+        for (int16_t i = 0; i < glyph.advance; i++) {
+            // the blank columns either side of a proportional glyph aren't
+            // stored
+            uint8_t bits = ((unsigned int) (i - glyph.left) < glyph.width) ? reader.next() : 0x00;
+
+            if (i >= i0 && i < i1) {
+                if (low) {
+                    combine<M>(row[i], low, bits << shift);
+                }
+                if (high) {
+                    combine<M>(row[i + _width], high, bits >> (8 - shift));
+                }
+            }
+        }
+
+        if (low) {
+            mark_dirty(x + i0, bank);
+            mark_dirty(x + i1 - 1, bank);
+        }
+        if (high) {
+            mark_dirty(x + i0, bank + 1);
+            mark_dirty(x + i1 - 1, bank + 1);
+        }
+#endif
+    }
 }
 
-void Nokia5110::draw_bitmap(const uint8_t *bmp, uint8_t x, uint8_t y, uint8_t width, uint8_t height, Mode mode) {
+void Nokia5110Canvas::draw_bitmap(const uint8_t *bmp, uint8_t x, uint8_t y, uint8_t width, uint8_t height, Mode mode) {
     uint8_t mask = 0x80;
 
     for (uint8_t dy = 0; dy < height; dy++) {
         for (uint8_t dx = 0; dx < width; dx++) {
-            draw_pixel(x + dx, y + dy, *bmp & mask, mode);
+            clip_pixel(x + dx, y + dy, (bool) (*bmp & mask), mode);
             mask >>= 1;
 
             if (mask == 0) { // if we reached the end of the byte
@@ -221,46 +1426,279 @@ void Nokia5110::draw_bitmap(const uint8_t *bmp, uint8_t x, uint8_t y, uint8_t wi
     }
 }
 
-void Nokia5110::draw_wbitmap(const uint8_t *wbmp, uint8_t x, uint8_t y, Mode mode) {
-    if (*wbmp++ != 0x00) { // image type, only supports 0
+void Nokia5110Canvas::draw_native_bitmap(const uint8_t *data, uint8_t x, uint8_t y, uint8_t width, uint8_t height, Mode mode) {
+#if LCD_REFERENCE_RASTER
+    for (uint8_t bank = 0; bank * 8 < height; bank++) {
+        for (uint8_t dx = 0; dx < width; dx++) {
+            for (uint8_t b = 0; b < 8 && bank * 8 + b < height; b++) {
+                clip_pixel(x + dx, y + bank * 8 + b, (bool) (*data & (1 << b)), mode);
+            }
+            data++;
+        }
+    }
+#else
+    for (uint8_t bank = 0; bank * 8 < height; bank++) {
+        // rows past the bottom of the bitmap arent drawn
+        uint8_t mask = (height - bank * 8 >= 8) ? 0xFF : (1 << (height - bank * 8)) - 1;
+#if LCD_WRAPAROUND
+        uint8_t top = y + bank * 8;
+#endif
+
+        for (uint8_t dx = 0; dx < width; dx++) {
+            uint8_t bits = *data++;
+
+#if LCD_WRAPAROUND
+            uint8_t col = (uint8_t) (x + dx) % _width;
+
+            // coordinates wrap at 256 before they wrap to the screen
+            if (top > 0x100 - 8) {
+                uint8_t rows = 0x100 - top; // rows before wrapping
+                uint8_t low = (1 << rows) - 1;
+                draw_column_byte(col, top % _height, mask & low, bits, mode);
+                draw_column_byte(col, 0, mask >> rows, bits >> rows, mode);
+            } else {
+                draw_column_byte(col, top % _height, mask, bits, mode);
+            }
+#else
+            draw_column_byte(x + dx, y + bank * 8, mask, bits, mode);
+#endif
+        }
+    }
+#endif
+}
+
+void Nokia5110Canvas::blit(const Nokia5110Canvas &src, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1,
+                           int16_t x, int16_t y, Mode mode) {
+    static void (Nokia5110Canvas::*const kernels[8])(const Nokia5110Canvas &, uint8_t, uint8_t, uint8_t, uint8_t,
+                                                     int16_t, int16_t) = LCD_MODE_TABLE(blit);
+    (this->*kernels[mode & 0x7])(src, x0, y0, x1, y1, x, y);
+}
+
+template <Nokia5110Canvas::Mode M>
+void Nokia5110Canvas::blit(const Nokia5110Canvas &src, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1,
+                           int16_t x, int16_t y) {
+    if (x0 > x1) {
+        uint8_t tmp = x0;
+        x0 = x1;
+        x1 = tmp;
+    }
+
+    if (y0 > y1) {
+        uint8_t tmp = y0;
+        y0 = y1;
+        y1 = tmp;
+    }
+
+    // the part of the source rectangle that's on the source canvas
+    x1 = (x1 < src._width) ? x1 : src._width - 1;
+    y1 = (y1 < src._height) ? y1 : src._height - 1;
+    if (x0 > x1 || y0 > y1) {
         return;
     }
-    if (*wbmp++ != 0x00) { // always 0
+
+    // when copying within a canvas, pixels are copied away from the direction
+    // they move in, so none are overwritten before they're read
+    bool rightwards = x > x0;
+    bool downwards = y > y0;
+
+#if LCD_REFERENCE_RASTER || LCD_WRAPAROUND
+    for (unsigned int j = 0; j <= (unsigned int) (y1 - y0); j++) {
+        uint8_t sy = downwards ? y1 - j : y0 + j;
+
+        for (unsigned int i = 0; i <= (unsigned int) (x1 - x0); i++) {
+            uint8_t sx = rightwards ? x1 - i : x0 + i;
+            bool value = src._buffer[sx + (sy / 8) * src._width] & (1 << (sy % 8));
+
+            clip_pixel(x + (sx - x0), y + (sy - y0), value, M);
+        }
+    }
+#else
+    // the part of the destination rectangle that's in the clip rectangle
+    int16_t dx0 = x;
+    int16_t dy0 = y;
+    int16_t dx1 = x + (x1 - x0);
+    int16_t dy1 = y + (y1 - y0);
+
+    if (dx0 < _clip_x0) {
+        x0 += _clip_x0 - dx0;
+        dx0 = _clip_x0;
+    }
+    if (dy0 < _clip_y0) {
+        y0 += _clip_y0 - dy0;
+        dy0 = _clip_y0;
+    }
+    dx1 = (dx1 < _clip_x1) ? dx1 : _clip_x1;
+    dy1 = (dy1 < _clip_y1) ? dy1 : _clip_y1;
+    if (dx0 > dx1 || dy0 > dy1) {
         return;
     }
-    uint8_t width = *wbmp++; // image width in pixels
-    uint8_t height = *wbmp++; // image height in pixels
 
-    uint8_t mask = 0x80;
+    uint8_t cols = dx1 - dx0 + 1;
+    uint8_t bank0 = dy0 / 8;
+    uint8_t bank1 = dy1 / 8;
 
-    for (uint8_t dy = 0; dy < height; dy++) {
-        for (uint8_t dx = 0; dx < width; dx++) {
-            draw_pixel(x + dx, y + dy, *wbmp & mask, mode);
-            mask >>= 1;
+    for (uint8_t i = 0; i <= bank1 - bank0; i++) {
+        uint8_t bank = downwards ? bank1 - i : bank0 + i;
 
-            if (mask == 0) { // if we reached the end of the byte
-                mask = 0x80;
-                wbmp++;
+        // rows of the bank inside the rectangle
+        uint8_t mask = 0xFF;
+        if (bank == bank0) {
+            mask &= 0xFF << (dy0 % 8);
+        }
+        if (bank == bank1) {
+            mask &= 0xFF >> (7 - dy1 % 8);
+        }
+
+        // source row that lands on the top row of the bank, at most 7 rows
+        // above the source canvas. its bank and the one below are shifted
+        // together to line up with the bank
+        int16_t top = bank * 8 - dy0 + y0;
+        int16_t src_bank = (top + 8) / 8 - 1;
+        uint8_t shift = (top + 8) % 8;
+        const uint8_t *upper = (src_bank >= 0) ? src._buffer + src_bank * src._width + x0 : NULL;
+        const uint8_t *lower = (shift && src_bank + 1 < src._banks) ? src._buffer + (src_bank + 1) * src._width + x0 : NULL;
+        uint8_t *dst = _buffer + bank * _width + dx0;
+
+        for (uint8_t j = 0; j < cols; j++) {
+            uint8_t col = rightwards ? cols - 1 - j : j;
+            uint8_t bits = 0;
+
+            if (upper) {
+                bits |= upper[col] >> shift;
+            }
+            if (lower) {
+                bits |= lower[col] << (8 - shift);
+            }
+            combine<M>(dst[col], mask, bits);
+        }
+
+        mark_dirty(dx0, bank);
+        mark_dirty(dx1, bank);
+    }
+#endif
+}
+
+bool Nokia5110Canvas::draw_wbitmap(const uint8_t *wbmp, uint8_t x, uint8_t y, Mode mode) {
+#if LCD_WRAPAROUND
+    x %= _width;
+    y %= _height;
+#endif
+
+    return draw_wbitmap(read_memory, &wbmp, x, y, mode);
+}
+
+bool Nokia5110Canvas::draw_wbitmap(FILE *file, int16_t x, int16_t y, Mode mode) {
+    return draw_wbitmap(read_file, file, x, y, mode);
+}
+
+bool Nokia5110Canvas::draw_wbitmap(lcd_read_t read, void *ctx, int16_t x, int16_t y, Mode mode) {
+    uint32_t type;
+    uint32_t width;
+    uint32_t height;
+    uint8_t fix;
+
+    if (!read_varint(read, ctx, &type) || type != 0) { // image type, only supports 0
+        return false;
+    }
+    if (read(ctx, &fix, 1) != 1 || !skip_extensions(read, ctx, fix)) {
+        return false;
+    }
+    if (!read_varint(read, ctx, &width) || !read_varint(read, ctx, &height)) {
+        return false;
+    }
+
+    // the part of the image that's on the screen
+#if LCD_WRAPAROUND
+    int32_t x0 = (x < 0) ? -x : 0;
+    int32_t y0 = (y < 0) ? -y : 0;
+    int32_t x1 = ((int32_t) width < _width - x) ? (int32_t) width : _width - x;
+    int32_t y1 = ((int32_t) height < _height - y) ? (int32_t) height : _height - y;
+#else
+    int32_t x0 = (x < _clip_x0) ? _clip_x0 - x : 0;
+    int32_t y0 = (y < _clip_y0) ? _clip_y0 - y : 0;
+    int32_t x1 = ((int32_t) width < _clip_x1 + 1 - x) ? (int32_t) width : _clip_x1 + 1 - x;
+    int32_t y1 = ((int32_t) height < _clip_y1 + 1 - y) ? (int32_t) height : _clip_y1 + 1 - y;
+#endif
+
+    if (x0 >= x1 || y0 >= y1) { // entirely off the screen
+        return true;
+    }
+
+    // wbmps pad out the end of each row, and only the bytes holding visible
+    // columns are read
+    uint32_t stride = (width + 7) / 8;
+    uint32_t first = x0 / 8;
+    uint32_t count = (x1 - 1) / 8 - first + 1;
+    uint8_t row[0x100 / 8 + 2];
+
+    // rows are gathered into bank bytes and written out a bank at a time. a
+    // canvas is at most 255 columns wide
+    uint8_t bits[0x100];
+    uint8_t rows = 0;
+    memset(bits + x + x0, 0, x1 - x0);
+
+    for (int32_t dy = 0; dy < y0; dy++) {
+        if (read(ctx, NULL, stride) != stride) {
+            return false;
+        }
+    }
+
+    for (int32_t dy = y0; dy < y1; dy++) {
+        if (read(ctx, NULL, first) != first || read(ctx, row, count) != count) {
+            return false;
+        }
+        if (dy + 1 < y1 && read(ctx, NULL, stride - first - count) != stride - first - count) {
+            return false;
+        }
+
+        uint8_t sy = y + dy;
+        uint8_t bit = 1 << (sy % 8);
+
+        for (int32_t dx = x0; dx < x1; dx++) {
+            uint8_t set = row[dx / 8 - first] & (0x80 >> (dx % 8));
+#if LCD_REFERENCE_RASTER
+            draw_pixel(x + dx, sy, set, mode);
+#else
+            if (set) {
+                bits[x + dx] |= bit;
             }
+#endif
         }
-        if (mask != 0x80) {
-            mask = 0x80; // wbmps pad out the end of each y, so reset the mask
-            wbmp++;
+        rows |= bit;
+
+#if !LCD_REFERENCE_RASTER
+        if (sy % 8 == 7 || dy + 1 == y1) { // end of a bank
+            for (uint8_t col = x + x0; col < x + x1; col++) {
+                apply_byte(col, sy / 8, rows, bits[col], mode);
+            }
+            memset(bits + x + x0, 0, x1 - x0);
+            rows = 0;
         }
+#endif
     }
+
+    return true;
+}
+
+void Nokia5110Canvas::draw_line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, const Pattern &pattern, Mode mode) {
+    static void (Nokia5110Canvas::*const kernels[8])(uint8_t, uint8_t, uint8_t, uint8_t, const Pattern &) = LCD_MODE_TABLE(draw_line);
+    (this->*kernels[mode & 0x7])(x0, y0, x1, y1, pattern);
 }
 
-void Nokia5110::draw_line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, const pattern_t pattern, Mode mode) {
+template <Nokia5110Canvas::Mode M>
+void Nokia5110Canvas::draw_line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, const Pattern &pattern) {
+    const Pattern anchored = pattern.anchored((x0 < x1) ? x0 : x1, (y0 < y1) ? y0 : y1);
+
     uint8_t dx = abs(x1 - x0);
     uint8_t dy = abs(y1 - y0);
 
     //use faster algorithms for horizontal and vertical lines
     if (dy == 0) {
-        draw_hline(x0, x1, y0, pattern, mode);
+        draw_hline<M>(x0, x1, y0, anchored);
         return;
     }
     if (dx == 0) {
-        draw_vline(y0, y1, x0, pattern, mode);
+        draw_vline<M>(y0, y1, x0, anchored);
         return;
     }
 
@@ -268,22 +1706,25 @@ void Nokia5110::draw_line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, const
     int8_t x_mult = (x0 > x1) ? -1 : 1;
     int8_t y_mult = (y0 > y1) ? -1 : 1;
 
-    if (dy < dx) { //positive slope
-        int8_t d = (2 * dy) - dx;
+    // error terms are 16 bit, a line can be up to 255 pixels long each way
+
+#if LCD_REFERENCE_RASTER
+    if (dy < dx) { //shallow
+        int16_t d = (2 * dy) - dx;
         uint8_t y = 0;
-        for (uint8_t x = 0; x <= dx; x++) {
-            draw_pixel(x0 + (x_mult * x), y0 + (y_mult * y), pattern, mode);
+        for (unsigned int x = 0; x <= dx; x++) {
+            draw_pixel(x0 + (x_mult * x), y0 + (y_mult * y), anchored, M);
             if (d > 0) {
                 y++;
                 d -= dx;
             }
             d += dy;
         }
-    } else { //negative slope
-        int8_t d = (2 * dx) - dy;
+    } else { //steep
+        int16_t d = (2 * dx) - dy;
         uint8_t x = 0;
-        for (uint8_t y = 0; y <= dy; y++) {
-            draw_pixel(x0 + (x_mult * x), y0 + (y_mult * y), pattern, mode);
+        for (unsigned int y = 0; y <= dy; y++) {
+            draw_pixel(x0 + (x_mult * x), y0 + (y_mult * y), anchored, M);
             if (d > 0) {
                 x++;
                 d -= dy;
@@ -291,40 +1732,210 @@ void Nokia5110::draw_line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, const
             d += dx;
         }
     }
+#else
+    // same steps as above, but instead of drawing each pixel the line is cut
+    // into runs along the major axis, and each run is drawn in one go. if the
+    // start of the line is clipped off, the steps start part way along
+    unsigned int run = 0;
+    unsigned int first = 0;
+
+    if (dy < dx) { //shallow, horizontal runs
+        unsigned int last = dx;
+#if !LCD_WRAPAROUND
+        if (!clip_line(x0, x_mult, _clip_x0, _clip_x1, y0, y_mult, _clip_y0, _clip_y1, dx, dy, &first, &last)) {
+            return;
+        }
+#endif
+        uint8_t y = first ? (dy * (first + 1) - 1) / dx : 0;
+        int16_t d = (2 * dy) - dx + (int32_t) first * dy - (int32_t) y * dx;
+        x0 += x_mult * (int) first;
+        y0 += y_mult * y;
+
+        for (unsigned int x = first; x <= last; x++) {
+            run++;
+            if (d > 0) {
+                draw_row_run<M>(x0, y0, run, x_mult, anchored);
+                x0 += x_mult * run;
+                y0 += y_mult;
+                run = 0;
+                d -= dx;
+            }
+            d += dy;
+        }
+
+        if (run) {
+            draw_row_run<M>(x0, y0, run, x_mult, anchored);
+        }
+    } else { //steep, vertical runs
+        unsigned int last = dy;
+#if !LCD_WRAPAROUND
+        if (!clip_line(y0, y_mult, _clip_y0, _clip_y1, x0, x_mult, _clip_x0, _clip_x1, dy, dx, &first, &last)) {
+            return;
+        }
+#endif
+        uint8_t x = first ? (dx * (first + 1) - 1) / dy : 0;
+        int16_t d = (2 * dx) - dy + (int32_t) first * dx - (int32_t) x * dy;
+        x0 += x_mult * x;
+        y0 += y_mult * (int) first;
+
+        for (unsigned int y = first; y <= last; y++) {
+            run++;
+            if (d > 0) {
+                draw_column_run<M>(x0, y0, run, y_mult, anchored);
+                x0 += x_mult;
+                y0 += y_mult * run;
+                run = 0;
+                d -= dy;
+            }
+            d += dx;
+        }
+
+        if (run) {
+            draw_column_run<M>(x0, y0, run, y_mult, anchored);
+        }
+    }
+#endif
+}
+
+void Nokia5110Canvas::draw_hline(uint8_t x0, uint8_t x1, uint8_t y, const Pattern &pattern, Mode mode) {
+    static void (Nokia5110Canvas::*const kernels[8])(uint8_t, uint8_t, uint8_t, const Pattern &) = LCD_MODE_TABLE(draw_hline);
+    (this->*kernels[mode & 0x7])(x0, x1, y, pattern);
 }
 
-void Nokia5110::draw_hline(uint8_t x0, uint8_t x1, uint8_t y, const pattern_t pattern, Mode mode) {
+template <Nokia5110Canvas::Mode M>
+void Nokia5110Canvas::draw_hline(uint8_t x0, uint8_t x1, uint8_t y, const Pattern &pattern) {
     if (x0 > x1) {
         uint8_t tmp = x0;
         x0 = x1;
         x1 = tmp;
     }
 
-    for (uint8_t x = x0; x <= x1; x++) {
-        draw_pixel(x, y, pattern, mode);
+    const Pattern anchored = pattern.anchored(x0, y);
+
+#if !LCD_WRAPAROUND
+    if (y < _clip_y0 || y > _clip_y1) {
+        return;
+    }
+    x0 = (x0 > _clip_x0) ? x0 : _clip_x0;
+    x1 = (x1 < _clip_x1) ? x1 : _clip_x1;
+    if (x0 > x1) {
+        return;
+    }
+#endif
+
+#if LCD_REFERENCE_RASTER
+    for (unsigned int x = x0; x <= x1; x++) {
+        draw_pixel(x, y, anchored, M);
     }
+#else
+    draw_row_run<M>(x0, y, x1 - x0 + 1, 1, anchored);
+#endif
 }
 
-void Nokia5110::draw_vline(uint8_t y0, uint8_t y1, uint8_t x, const pattern_t pattern, Mode mode) {
+void Nokia5110Canvas::draw_vline(uint8_t y0, uint8_t y1, uint8_t x, const Pattern &pattern, Mode mode) {
+    static void (Nokia5110Canvas::*const kernels[8])(uint8_t, uint8_t, uint8_t, const Pattern &) = LCD_MODE_TABLE(draw_vline);
+    (this->*kernels[mode & 0x7])(y0, y1, x, pattern);
+}
+
+template <Nokia5110Canvas::Mode M>
+void Nokia5110Canvas::draw_vline(uint8_t y0, uint8_t y1, uint8_t x, const Pattern &pattern) {
     if (y0 > y1) {
         uint8_t tmp = y0;
         y0 = y1;
         y1 = tmp;
     }
 
-    for (uint8_t y = y0; y <= y1; y++) {
-        draw_pixel(x, y, pattern, mode);
+    const Pattern anchored = pattern.anchored(x, y0);
+
+#if !LCD_WRAPAROUND
+    if (x < _clip_x0 || x > _clip_x1) {
+        return;
+    }
+    y0 = (y0 > _clip_y0) ? y0 : _clip_y0;
+    y1 = (y1 < _clip_y1) ? y1 : _clip_y1;
+    if (y0 > y1) {
+        return;
+    }
+#endif
+
+#if LCD_REFERENCE_RASTER
+    for (unsigned int y = y0; y <= y1; y++) {
+        draw_pixel(x, y, anchored, M);
+    }
+#else
+    draw_column<M>(x, y0, y1, false, anchored);
+#endif
+}
+
+template <Nokia5110Canvas::Mode M>
+void Nokia5110Canvas::draw_row_run(uint8_t x, uint8_t y, unsigned int len, int8_t step, const Pattern &pattern) {
+    // everything but the column is the same for the whole run
+    uint8_t bank = wrap_y(y) / 8;
+    uint8_t bit = 1 << (y % 8);
+    uint8_t *line = _buffer + bank * _width;
+
+    while (len--) {
+        uint8_t col = wrap_x(x);
+
+        combine<M>(line[col], bit, pattern.columns[x % 8]);
+        mark_dirty(col, bank);
+        x += step;
+    }
+}
+
+template <Nokia5110Canvas::Mode M>
+void Nokia5110Canvas::draw_column_run(uint8_t x, uint8_t y, unsigned int len, int8_t step, const Pattern &pattern) {
+    // coordinates wrap at 256 before they wrap to the screen, so a run that
+    // crosses 255 is drawn as two pieces, in the order the rows are visited
+    if (step > 0) {
+        unsigned int end = y + len - 1;
+        if (end > 0xFF) {
+            draw_column<M>(x, y, 0xFF, false, pattern);
+            draw_column<M>(x, 0, end - 0x100, false, pattern);
+        } else {
+            draw_column<M>(x, y, end, false, pattern);
+        }
+    } else {
+        int start = y - (int) (len - 1);
+        if (start < 0) {
+            draw_column<M>(x, 0, y, true, pattern);
+            draw_column<M>(x, start + 0x100, 0xFF, true, pattern);
+        } else {
+            draw_column<M>(x, start, y, true, pattern);
+        }
+    }
+}
+
+template <Nokia5110Canvas::Mode M>
+void Nokia5110Canvas::draw_column(uint8_t x, unsigned int y0, unsigned int y1, bool reverse, const Pattern &pattern) {
+    uint8_t banks[LCD_MAX_SPANS];
+    uint8_t masks[LCD_MAX_SPANS];
+    uint8_t spans = column_spans(y0, y1, banks, masks);
+    uint8_t bits = pattern.columns[x % 8];
+
+    x = wrap_x(x);
+    for (uint8_t i = 0; i < spans; i++) {
+        uint8_t span = reverse ? spans - 1 - i : i;
+        apply_byte<M>(x, banks[span], masks[span], bits);
     }
 }
 
-void Nokia5110::draw_rect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, const pattern_t pattern, Mode mode) {
-    draw_hline(x0, x1, y0, pattern, mode);
-    draw_hline(x0, x1, y1, pattern, mode);
-    draw_vline(y0, y1, x0, pattern, mode);
-    draw_vline(y0, y1, x1, pattern, mode);
+void Nokia5110Canvas::draw_rect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, const Pattern &pattern, Mode mode) {
+    const Pattern anchored = pattern.anchored((x0 < x1) ? x0 : x1, (y0 < y1) ? y0 : y1);
+
+    draw_hline(x0, x1, y0, anchored, mode);
+    draw_hline(x0, x1, y1, anchored, mode);
+    draw_vline(y0, y1, x0, anchored, mode);
+    draw_vline(y0, y1, x1, anchored, mode);
+}
+
+void Nokia5110Canvas::fill_rect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, const Pattern &pattern, Mode mode) {
+    static void (Nokia5110Canvas::*const kernels[8])(uint8_t, uint8_t, uint8_t, uint8_t, const Pattern &) = LCD_MODE_TABLE(fill_rect);
+    (this->*kernels[mode & 0x7])(x0, y0, x1, y1, pattern);
 }
 
-void Nokia5110::fill_rect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, const pattern_t pattern, Mode mode) {
+template <Nokia5110Canvas::Mode M>
+void Nokia5110Canvas::fill_rect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, const Pattern &pattern) {
     if (x0 > x1) {
         uint8_t tmp = x0;
         x0 = x1;
@@ -337,14 +1948,41 @@ void Nokia5110::fill_rect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, const
         y1 = tmp;
     }
 
-    for (uint8_t x = x0; x <= x1; x++) {
-        for (uint8_t y = y0; y <= y1; y++) {
-            draw_pixel(x, y, pattern, mode);
+    const Pattern anchored = pattern.anchored(x0, y0);
+
+#if !LCD_WRAPAROUND
+    x0 = (x0 > _clip_x0) ? x0 : _clip_x0;
+    y0 = (y0 > _clip_y0) ? y0 : _clip_y0;
+    x1 = (x1 < _clip_x1) ? x1 : _clip_x1;
+    y1 = (y1 < _clip_y1) ? y1 : _clip_y1;
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+#endif
+
+#if LCD_REFERENCE_RASTER
+    for (unsigned int x = x0; x <= x1; x++) {
+        for (unsigned int y = y0; y <= y1; y++) {
+            draw_pixel(x, y, anchored, M);
+        }
+    }
+#else
+    uint8_t banks[LCD_MAX_SPANS];
+    uint8_t masks[LCD_MAX_SPANS];
+    uint8_t spans = column_spans(y0, y1, banks, masks);
+
+    // columns outermost, so pixels that wrap onto each other are drawn in the
+    // same order as draw_pixel() would
+    for (unsigned int x = x0; x <= x1; x++) {
+        uint8_t col = wrap_x(x);
+        for (uint8_t i = 0; i < spans; i++) {
+            apply_byte<M>(col, banks[i], masks[i], anchored.columns[x % 8]);
         }
     }
+#endif
 }
 
-void Nokia5110::draw_rrect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t r, const pattern_t pattern, Mode mode) {
+void Nokia5110Canvas::draw_rrect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t r, const Pattern &pattern, Mode mode) {
     if (x0 > x1) {
         uint8_t tmp = x0;
         x0 = x1;
@@ -357,15 +1995,17 @@ void Nokia5110::draw_rrect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8
         y1 = tmp;
     }
 
-    uint8_t cx0 = x0 + r;
-    uint8_t cy0 = y0 + r;
-    uint8_t cx1 = x1 - r;
-    uint8_t cy1 = y1 - r;
+    const Pattern anchored = pattern.anchored(x0, y0);
+
+    int16_t cx0 = x0 + r;
+    int16_t cy0 = y0 + r;
+    int16_t cx1 = x1 - r;
+    int16_t cy1 = y1 - r;
 
-    draw_hline(cx0, cx1, y0, pattern, mode);
-    draw_hline(cx0, cx1, y1, pattern, mode);
-    draw_vline(cy0, cy1, x0, pattern, mode);
-    draw_vline(cy0, cy1, x1, pattern, mode);
+    clip_hline(cx0, cx1, y0, anchored, mode);
+    clip_hline(cx0, cx1, y1, anchored, mode);
+    clip_vline(cy0, cy1, x0, anchored, mode);
+    clip_vline(cy0, cy1, x1, anchored, mode);
 
     uint8_t x = r; // start at the cardinal points of the circle
     uint8_t y = 1;
@@ -382,14 +2022,14 @@ void Nokia5110::draw_rrect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8
     // magic Bresenham voodoo
     while (x > y) {
         // draw each octant
-        draw_pixel(cx1 + x, cy1 + y, pattern, mode);
-        draw_pixel(cx1 + x, cy0 - y, pattern, mode);
-        draw_pixel(cx0 - x, cy1 + y, pattern, mode);
-        draw_pixel(cx0 - x, cy0 - y, pattern, mode);
-        draw_pixel(cx1 + y, cy1 + x, pattern, mode);
-        draw_pixel(cx1 + y, cy0 - x, pattern, mode);
-        draw_pixel(cx0 - y, cy1 + x, pattern, mode);
-        draw_pixel(cx0 - y, cy0 - x, pattern, mode);
+        clip_pixel(cx1 + x, cy1 + y, anchored, mode);
+        clip_pixel(cx1 + x, cy0 - y, anchored, mode);
+        clip_pixel(cx0 - x, cy1 + y, anchored, mode);
+        clip_pixel(cx0 - x, cy0 - y, anchored, mode);
+        clip_pixel(cx1 + y, cy1 + x, anchored, mode);
+        clip_pixel(cx1 + y, cy0 - x, anchored, mode);
+        clip_pixel(cx0 - y, cy1 + x, anchored, mode);
+        clip_pixel(cx0 - y, cy0 - x, anchored, mode);
 
         y++;
         err += dy;
@@ -404,13 +2044,13 @@ void Nokia5110::draw_rrect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8
 
 
     //draw 45° pixels
-    draw_pixel(cx1 + x, cy1 + y, pattern, mode);
-    draw_pixel(cx0 - x, cy1 + y, pattern, mode);
-    draw_pixel(cx1 + x, cy0 - y, pattern, mode);
-    draw_pixel(cx0 - x, cy0 - y, pattern, mode);
+    clip_pixel(cx1 + x, cy1 + y, anchored, mode);
+    clip_pixel(cx0 - x, cy1 + y, anchored, mode);
+    clip_pixel(cx1 + x, cy0 - y, anchored, mode);
+    clip_pixel(cx0 - x, cy0 - y, anchored, mode);
 }
 
-void Nokia5110::fill_rrect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t r, const pattern_t pattern, Mode mode) {
+void Nokia5110Canvas::fill_rrect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t r, const Pattern &pattern, Mode mode) {
     if (x0 > x1) {
         uint8_t tmp = x0;
         x0 = x1;
@@ -423,12 +2063,14 @@ void Nokia5110::fill_rrect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8
         y1 = tmp;
     }
 
-    uint8_t cx0 = x0 + r;
-    uint8_t cy0 = y0 + r;
-    uint8_t cx1 = x1 - r;
-    uint8_t cy1 = y1 - r;
+    const Pattern anchored = pattern.anchored(x0, y0);
 
-    fill_rect(cx0, y0, cx1, y1, pattern, mode);
+    int16_t cx0 = x0 + r;
+    int16_t cy0 = y0 + r;
+    int16_t cx1 = x1 - r;
+    int16_t cy1 = y1 - r;
+
+    clip_fill_rect(cx0, y0, cx1, y1, anchored, mode);
 
     uint8_t x = r; // start at the cardinal points of the circle
     uint8_t y = 1;
@@ -438,8 +2080,8 @@ void Nokia5110::fill_rrect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8
 
     // magic Bresenham voodoo
     while (x > y) {
-        draw_vline(cy0 - x, cy1 + x, cx1 + y, pattern, mode);
-        draw_vline(cy0 - x, cy1 + x, cx0 - y, pattern, mode);
+        clip_vline(cy0 - x, cy1 + x, cx1 + y, anchored, mode);
+        clip_vline(cy0 - x, cy1 + x, cx0 - y, anchored, mode);
 
         y++;
         err += dy;
@@ -449,26 +2091,28 @@ void Nokia5110::fill_rrect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8
             x--;
             err += dx;
             dx += 2;
-            draw_vline(cy0 - (y - 1), cy1 + (y - 1), cx1 + (x + 1), pattern, mode);
-            draw_vline(cy0 - (y - 1), cy1 + (y - 1), cx0 - (x + 1), pattern, mode);
+            clip_vline(cy0 - (y - 1), cy1 + (y - 1), cx1 + (x + 1), anchored, mode);
+            clip_vline(cy0 - (y - 1), cy1 + (y - 1), cx0 - (x + 1), anchored, mode);
         }
     }
 
-    draw_vline(cy0 - y, cy1 + y, cx1 + x, pattern, mode);
-    draw_vline(cy0 - y, cy1 + y, cx0 - x, pattern, mode);
+    clip_vline(cy0 - y, cy1 + y, cx1 + x, anchored, mode);
+    clip_vline(cy0 - y, cy1 + y, cx0 - x, anchored, mode);
 }
 
-void Nokia5110::draw_circle(uint8_t cx, uint8_t cy, uint8_t r, const pattern_t pattern, Mode mode) {
+void Nokia5110Canvas::draw_circle(uint8_t cx, uint8_t cy, uint8_t r, const Pattern &pattern, Mode mode) {
+    const Pattern anchored = pattern.anchored(cx - r, cy - r);
+
     if (!r) { // you cant have a radius of 0, silly
-        draw_pixel(cx, cy, pattern, mode);
+        clip_pixel(cx, cy, anchored, mode);
         return;
     }
 
     // draw the pixels in the cardinal directions
-    draw_pixel(cx + r, cy, pattern, mode);
-    draw_pixel(cx - r, cy, pattern, mode);
-    draw_pixel(cx, cy + r, pattern, mode);
-    draw_pixel(cx, cy - r, pattern, mode);
+    clip_pixel(cx + r, cy, anchored, mode);
+    clip_pixel(cx - r, cy, anchored, mode);
+    clip_pixel(cx, cy + r, anchored, mode);
+    clip_pixel(cx, cy - r, anchored, mode);
 
     uint8_t x = r; // start at the cardinal points of the circle
     uint8_t y = 1;
@@ -485,14 +2129,14 @@ void Nokia5110::draw_circle(uint8_t cx, uint8_t cy, uint8_t r, const pattern_t p
     // magic Bresenham voodoo
     while (x > y) {
         // draw each octant
-        draw_pixel(cx + x, cy + y, pattern, mode);
-        draw_pixel(cx + x, cy - y, pattern, mode);
-        draw_pixel(cx - x, cy + y, pattern, mode);
-        draw_pixel(cx - x, cy - y, pattern, mode);
-        draw_pixel(cx + y, cy + x, pattern, mode);
-        draw_pixel(cx + y, cy - x, pattern, mode);
-        draw_pixel(cx - y, cy + x, pattern, mode);
-        draw_pixel(cx - y, cy - x, pattern, mode);
+        clip_pixel(cx + x, cy + y, anchored, mode);
+        clip_pixel(cx + x, cy - y, anchored, mode);
+        clip_pixel(cx - x, cy + y, anchored, mode);
+        clip_pixel(cx - x, cy - y, anchored, mode);
+        clip_pixel(cx + y, cy + x, anchored, mode);
+        clip_pixel(cx + y, cy - x, anchored, mode);
+        clip_pixel(cx - y, cy + x, anchored, mode);
+        clip_pixel(cx - y, cy - x, anchored, mode);
 
         y++;
         err += dy;
@@ -506,19 +2150,21 @@ void Nokia5110::draw_circle(uint8_t cx, uint8_t cy, uint8_t r, const pattern_t p
     }
 
     //draw 45° pixels
-    draw_pixel(cx + x, cy + y, pattern, mode);
-    draw_pixel(cx - x, cy + y, pattern, mode);
-    draw_pixel(cx + x, cy - y, pattern, mode);
-    draw_pixel(cx - x, cy - y, pattern, mode);
+    clip_pixel(cx + x, cy + y, anchored, mode);
+    clip_pixel(cx - x, cy + y, anchored, mode);
+    clip_pixel(cx + x, cy - y, anchored, mode);
+    clip_pixel(cx - x, cy - y, anchored, mode);
 }
 
-void Nokia5110::fill_circle(uint8_t cx, uint8_t cy, uint8_t r, const uint8_t *pattern, Nokia5110::Mode mode) {
+void Nokia5110Canvas::fill_circle(uint8_t cx, uint8_t cy, uint8_t r, const Pattern &pattern, Mode mode) {
+    const Pattern anchored = pattern.anchored(cx - r, cy - r);
+
     if (!r) { // you cant have a radius of 0, silly
-        draw_pixel(cx, cy, pattern, mode);
+        clip_pixel(cx, cy, anchored, mode);
         return;
     }
 
-    draw_vline(cy - r, cy + r, cx, pattern, mode);
+    clip_vline(cy - r, cy + r, cx, anchored, mode);
 
     uint8_t x = r; // start at the cardinal points of the circle
     uint8_t y = 1;
@@ -528,8 +2174,8 @@ void Nokia5110::fill_circle(uint8_t cx, uint8_t cy, uint8_t r, const uint8_t *pa
 
     // magic Bresenham voodoo
     while (x > y) {
-        draw_vline(cy - x, cy + x, cx + y, pattern, mode);
-        draw_vline(cy - x, cy + x, cx - y, pattern, mode);
+        clip_vline(cy - x, cy + x, cx + y, anchored, mode);
+        clip_vline(cy - x, cy + x, cx - y, anchored, mode);
 
         y++;
         err += dy;
@@ -539,38 +2185,41 @@ void Nokia5110::fill_circle(uint8_t cx, uint8_t cy, uint8_t r, const uint8_t *pa
             x--;
             err += dx;
             dx += 2;
-            draw_vline(cy - (y - 1), cy + (y - 1), cx + (x + 1), pattern, mode);
-            draw_vline(cy - (y - 1), cy + (y - 1), cx - (x + 1), pattern, mode);
+            clip_vline(cy - (y - 1), cy + (y - 1), cx + (x + 1), anchored, mode);
+            clip_vline(cy - (y - 1), cy + (y - 1), cx - (x + 1), anchored, mode);
         }
     }
 
-    draw_vline(cy - y, cy + y, cx + x, pattern, mode);
-    draw_vline(cy - y, cy + y, cx - x, pattern, mode);
+    clip_vline(cy - y, cy + y, cx + x, anchored, mode);
+    clip_vline(cy - y, cy + y, cx - x, anchored, mode);
 }
 
-void Nokia5110::draw_ellipse(uint8_t cx, uint8_t cy, uint8_t a, uint8_t b, const pattern_t pattern, Mode mode) {
+void Nokia5110Canvas::draw_ellipse(uint8_t cx, uint8_t cy, uint8_t a, uint8_t b, const Pattern &pattern, Mode mode) {
+    const Pattern anchored = pattern.anchored(cx - a, cy - b);
+
     if (!a) { // you cant have a radius of 0, silly
-        draw_vline(cy - b, cy + b, cx, pattern, mode);
+        clip_vline(cy - b, cy + b, cx, anchored, mode);
         return;
     }
     if (!b) { // you cant have a radius of 0, silly
-        draw_hline(cx - a, cx + a, cy, pattern, mode);
+        clip_hline(cx - a, cx + a, cy, anchored, mode);
         return;
     }
 
-    draw_pixel(cx + a, cy, pattern, mode);
-    draw_pixel(cx - a, cy, pattern, mode);
-    draw_pixel(cx, cy + b, pattern, mode);
-    draw_pixel(cx, cy - b, pattern, mode);
+    clip_pixel(cx + a, cy, anchored, mode);
+    clip_pixel(cx - a, cy, anchored, mode);
+    clip_pixel(cx, cy + b, anchored, mode);
+    clip_pixel(cx, cy - b, anchored, mode);
 
-    uint16_t two_a_sqr = 2 * a * a;
-    uint16_t two_b_sqr = 2 * b * b;
+    // 32 bit error terms, the squares overflow 16 bits for radii over 90
+    int32_t two_a_sqr = 2 * a * a;
+    int32_t two_b_sqr = 2 * b * b;
 
-    uint8_t x = a; // start at the cardinal points
-    uint8_t y = 1;
-    int16_t dx = b * b * (1 - (2 * a));
-    int16_t dy = 3 * a * a;
-    int16_t err = a * a;
+    int16_t x = a; // start at the cardinal points
+    int16_t y = 1;
+    int32_t dx = b * b * (1 - (2 * a));
+    int32_t dy = 3 * a * a;
+    int32_t err = a * a;
     uint8_t stop_x = a * a / (isqrt(a * a + b));
 
     if (dx + two_a_sqr > 0) {
@@ -581,10 +2230,10 @@ void Nokia5110::draw_ellipse(uint8_t cx, uint8_t cy, uint8_t a, uint8_t b, const
 
     // section 1 (left and right)
     while (x >= stop_x) {
-        draw_pixel(cx + x, cy + y, pattern, mode);
-        draw_pixel(cx - x, cy + y, pattern, mode);
-        draw_pixel(cx + x, cy - y, pattern, mode);
-        draw_pixel(cx - x, cy - y, pattern, mode);
+        clip_pixel(cx + x, cy + y, anchored, mode);
+        clip_pixel(cx - x, cy + y, anchored, mode);
+        clip_pixel(cx + x, cy - y, anchored, mode);
+        clip_pixel(cx - x, cy - y, anchored, mode);
 
         y++;
         err += dy;
@@ -597,7 +2246,7 @@ void Nokia5110::draw_ellipse(uint8_t cx, uint8_t cy, uint8_t a, uint8_t b, const
         }
     }
 
-    uint8_t stop_y = y;
+    int16_t stop_y = y;
     x = 1;
     y = b;
     dx = 3 * b * b;
@@ -612,10 +2261,10 @@ void Nokia5110::draw_ellipse(uint8_t cx, uint8_t cy, uint8_t a, uint8_t b, const
 
     // section 2 (top and bottom)
     while (x < stop_x) {
-        draw_pixel(cx + x, cy + y, pattern, mode);
-        draw_pixel(cx - x, cy + y, pattern, mode);
-        draw_pixel(cx + x, cy - y, pattern, mode);
-        draw_pixel(cx - x, cy - y, pattern, mode);
+        clip_pixel(cx + x, cy + y, anchored, mode);
+        clip_pixel(cx - x, cy + y, anchored, mode);
+        clip_pixel(cx + x, cy - y, anchored, mode);
+        clip_pixel(cx - x, cy - y, anchored, mode);
 
         x++;
         err += dx;
@@ -629,33 +2278,36 @@ void Nokia5110::draw_ellipse(uint8_t cx, uint8_t cy, uint8_t a, uint8_t b, const
     }
 
     if (y >= stop_y) {
-        draw_vline(cy + y, cy + stop_y, cx + (x - 1), pattern, mode);
-        draw_vline(cy - y, cy - stop_y, cx + (x - 1), pattern, mode);
-        draw_vline(cy + y, cy + stop_y, cx - (x - 1), pattern, mode);
-        draw_vline(cy - y, cy - stop_y, cx - (x - 1), pattern, mode);
+        clip_vline(cy + y, cy + stop_y, cx + (x - 1), anchored, mode);
+        clip_vline(cy - y, cy - stop_y, cx + (x - 1), anchored, mode);
+        clip_vline(cy + y, cy + stop_y, cx - (x - 1), anchored, mode);
+        clip_vline(cy - y, cy - stop_y, cx - (x - 1), anchored, mode);
     }
 }
 
-void Nokia5110::fill_ellipse(uint8_t cx, uint8_t cy, uint8_t a, uint8_t b, const pattern_t pattern, Mode mode) {
+void Nokia5110Canvas::fill_ellipse(uint8_t cx, uint8_t cy, uint8_t a, uint8_t b, const Pattern &pattern, Mode mode) {
+    const Pattern anchored = pattern.anchored(cx - a, cy - b);
+
     if (!a) { // you cant have a radius of 0, silly
-        draw_vline(cy - b, cy + b, cx, pattern, mode);
+        clip_vline(cy - b, cy + b, cx, anchored, mode);
         return;
     }
     if (!b) { // you cant have a radius of 0, silly
-        draw_hline(cx - a, cx + a, cy, pattern, mode);
+        clip_hline(cx - a, cx + a, cy, anchored, mode);
         return;
     }
 
-    draw_vline(cy + b, cy - b, cx, pattern, mode);
+    clip_vline(cy + b, cy - b, cx, anchored, mode);
 
-    uint16_t two_a_sqr = 2 * a * a;
-    uint16_t two_b_sqr = 2 * b * b;
+    // 32 bit error terms, the squares overflow 16 bits for radii over 90
+    int32_t two_a_sqr = 2 * a * a;
+    int32_t two_b_sqr = 2 * b * b;
 
-    int8_t x = a; // start at the cardinal points
-    int8_t y = 1;
-    int16_t dx = b * b * (1 - (2 * a));
-    int16_t dy = 3 * a * a;
-    int16_t err = a * a;
+    int16_t x = a; // start at the cardinal points
+    int16_t y = 1;
+    int32_t dx = b * b * (1 - (2 * a));
+    int32_t dy = 3 * a * a;
+    int32_t err = a * a;
     uint8_t stop_x = a * a / (isqrt(a * a + b));
 
     if (dx + two_a_sqr > 0) {
@@ -671,8 +2323,8 @@ void Nokia5110::fill_ellipse(uint8_t cx, uint8_t cy, uint8_t a, uint8_t b, const
         dy += two_a_sqr;
 
         if ((err * 2) + dx > 0) {
-            draw_vline(cy + (y - 1), cy - (y - 1), cx + x, pattern, mode);
-            draw_vline(cy + (y - 1), cy - (y - 1), cx - x, pattern, mode);
+            clip_vline(cy + (y - 1), cy - (y - 1), cx + x, anchored, mode);
+            clip_vline(cy + (y - 1), cy - (y - 1), cx - x, anchored, mode);
 
             x--;
             err += dx;
@@ -694,8 +2346,8 @@ void Nokia5110::fill_ellipse(uint8_t cx, uint8_t cy, uint8_t a, uint8_t b, const
 
     // section 2 (top and bottom)
     while (x < stop_x) {
-        draw_vline(cy + y, cy - y, cx + x, pattern, mode);
-        draw_vline(cy + y, cy - y, cx - x, pattern, mode);
+        clip_vline(cy + y, cy - y, cx + x, anchored, mode);
+        clip_vline(cy + y, cy - y, cx - x, anchored, mode);
 
         x++;
         err += dx;
@@ -709,20 +2361,56 @@ void Nokia5110::fill_ellipse(uint8_t cx, uint8_t cy, uint8_t a, uint8_t b, const
     }
 }
 
-// patterns
-const pattern_t Nokia5110::pattern_black = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-
-const pattern_t Nokia5110::pattern_dkgrey = {0xEE, 0xBB, 0xEE, 0xBB, 0xEE, 0xBB, 0xEE, 0xBB};
-
-const pattern_t Nokia5110::pattern_grey = {0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55};
-
-const pattern_t Nokia5110::pattern_ltgrey = {0x11, 0x44, 0x11, 0x44, 0x11, 0x44, 0x11, 0x44};
-
-const pattern_t Nokia5110::pattern_white = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+// instantiate the templated primitives for every Mode, so they can be used
+// from other files
+#define LCD_INSTANTIATE(mode) \
+    template void Nokia5110Canvas::draw_pixel<mode>(uint8_t, uint8_t, bool); \
+    template void Nokia5110Canvas::draw_line<mode>(uint8_t, uint8_t, uint8_t, uint8_t, const Pattern &); \
+    template void Nokia5110Canvas::draw_hline<mode>(uint8_t, uint8_t, uint8_t, const Pattern &); \
+    template void Nokia5110Canvas::draw_vline<mode>(uint8_t, uint8_t, uint8_t, const Pattern &); \
+    template void Nokia5110Canvas::fill_rect<mode>(uint8_t, uint8_t, uint8_t, uint8_t, const Pattern &); \
+    template void Nokia5110Canvas::blit<mode>(const Nokia5110Canvas &, uint8_t, uint8_t, uint8_t, uint8_t, int16_t, int16_t);
+
+LCD_INSTANTIATE(Nokia5110Canvas::pixel_copy)
+LCD_INSTANTIATE(Nokia5110Canvas::pixel_or)
+LCD_INSTANTIATE(Nokia5110Canvas::pixel_xor)
+LCD_INSTANTIATE(Nokia5110Canvas::pixel_clr)
+LCD_INSTANTIATE(Nokia5110Canvas::pixel_invt)
+LCD_INSTANTIATE(Nokia5110Canvas::pixel_nor)
+LCD_INSTANTIATE(Nokia5110Canvas::pixel_xnor)
+LCD_INSTANTIATE(Nokia5110Canvas::pixel_nclr)
+
+static constexpr pattern_t black_rows = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+constexpr Nokia5110Canvas::Pattern Nokia5110Canvas::pattern_black(black_rows);
+
+static constexpr pattern_t dkgrey_rows = {0xEE, 0xBB, 0xEE, 0xBB, 0xEE, 0xBB, 0xEE, 0xBB};
+constexpr Nokia5110Canvas::Pattern Nokia5110Canvas::pattern_dkgrey(dkgrey_rows);
+
+static constexpr pattern_t grey_rows = {0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55};
+constexpr Nokia5110Canvas::Pattern Nokia5110Canvas::pattern_grey(grey_rows);
+
+static constexpr pattern_t ltgrey_rows = {0x11, 0x44, 0x11, 0x44, 0x11, 0x44, 0x11, 0x44};
+constexpr Nokia5110Canvas::Pattern Nokia5110Canvas::pattern_ltgrey(ltgrey_rows);
+
+static constexpr pattern_t white_rows = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+constexpr Nokia5110Canvas::Pattern Nokia5110Canvas::pattern_white(white_rows);
+
+#if LCD_SCALE_CACHE
+Nokia5110Canvas::ScaledGlyph Nokia5110Canvas::_scale_cache[LCD_SCALE_CACHE];
+uint32_t Nokia5110Canvas::_scale_clock = 0;
+#endif
+
+// each nibble with every bit repeated 2, 3 and 4 times, for print_scaled()
+constexpr uint16_t Nokia5110Canvas::spread[3][16] = {
+    {0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F, 0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF},
+    {0x000, 0x007, 0x038, 0x03F, 0x1C0, 0x1C7, 0x1F8, 0x1FF, 0xE00, 0xE07, 0xE38, 0xE3F, 0xFC0, 0xFC7, 0xFF8, 0xFFF},
+    {0x0000, 0x000F, 0x00F0, 0x00FF, 0x0F00, 0x0F0F, 0x0FF0, 0x0FFF,
+     0xF000, 0xF00F, 0xF0F0, 0xF0FF, 0xFF00, 0xFF0F, 0xFFF0, 0xFFFF}
+};
 
 // font from
 // https://developer.mbed.org/users/eencae/code/N5110/docs/tip/N5110_8h_source.html
-const uint8_t Nokia5110::font[480] = {
+constexpr uint8_t Nokia5110Canvas::font_5x7_data[480] = {
     0x00, 0x00, 0x00, 0x00, 0x00, // (space)
     0x00, 0x00, 0x5F, 0x00, 0x00, // !
     0x00, 0x07, 0x00, 0x07, 0x00, // "
@@ -820,3 +2508,5 @@ const uint8_t Nokia5110::font[480] = {
     0x08, 0x08, 0x2A, 0x1C, 0x08, // ->
     0x08, 0x1C, 0x2A, 0x08, 0x08  // <-
 };
+
+constexpr Nokia5110Font Nokia5110Canvas::font_5x7 = {font_5x7_data, NULL, 0x20, 0x7F, 5, 8, 1, false};
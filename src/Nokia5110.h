@@ -17,8 +17,30 @@
 #ifndef NOKIA5110_H
 #define NOKIA5110_H
 
-#include <mbed.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Nokia5110Bitmap.h"
+#include "Nokia5110Font.h"
+#include "Nokia5110Transport.h"
+
+#ifdef __MBED__
+typedef Callback<void()> lcd_callback_t;
+#else
+#include <functional>
+typedef std::function<void()> lcd_callback_t;
+#endif
+
+/**
+ * @brief pulls image data from a stream
+ * @details reads up to len bytes into buf and returns how many were read. if
+ * buf is NULL, skips len bytes instead, so streams that can seek don't have
+ * to read data that won't be drawn
+ */
+typedef size_t (*lcd_read_t)(void *ctx, uint8_t *buf, size_t len);
 
 // 4MHz clock frequency, maximum of the display
 #define LCD_SPI_FREQ 400000
@@ -37,11 +59,90 @@
 */
 #define LCD_SPI_MODE 0x00
 
+// draw every primitive one pixel at a time through draw_pixel(), the way the
+// library always used to. slow, but gives a reference to check the optimized
+// raster code against pixel for pixel
+#ifndef LCD_REFERENCE_RASTER
+#define LCD_REFERENCE_RASTER 0
+#endif
+
+// wrap coordinates past the edge of the screen around to the other side, the
+// way the library always used to, instead of clipping them. the clip
+// rectangle is ignored
+#ifndef LCD_WRAPAROUND
+#define LCD_WRAPAROUND 0
+#endif
+
+// keep a shadow copy of the display's RAM so display() only sends the bytes
+// that changed since the last flush. costs another LCD_BYTES of RAM
+#ifndef LCD_SHADOW_BUFFER
+#define LCD_SHADOW_BUFFER 0
+#endif
+
+// draw into a back buffer while the front buffer is sent by display_async().
+// costs another LCD_BYTES of RAM
+#ifndef LCD_DOUBLE_BUFFER
+#define LCD_DOUBLE_BUFFER 0
+#endif
+
+// count pixels drawn, bytes sent and flushes, and keep a histogram of flush
+// times. see Nokia5110::stats()
+#ifndef LCD_STATS
+#define LCD_STATS 0
+#endif
+
+// flush time histogram buckets. bucket 0 counts flushes shorter than
+// LCD_STATS_BUCKET_US, each bucket after that is twice as wide, and the last
+// bucket counts everything longer
+#ifndef LCD_STATS_BUCKETS
+#define LCD_STATS_BUCKETS 8
+#endif
+#ifndef LCD_STATS_BUCKET_US
+#define LCD_STATS_BUCKET_US 250
+#endif
+
+// largest run of unchanged bytes the diff flush will resend rather than
+// moving the cursor past it. moving the cursor costs 2 command bytes plus
+// starting a new data transfer
+#ifndef LCD_DIFF_GAP
+#define LCD_DIFF_GAP 3
+#endif
+
+// glyphs print_scaled() keeps scaled, shared by every canvas. the least
+// recently drawn is replaced when a new one is needed. off by default, since
+// it costs LCD_SCALE_CACHE_BYTES of static RAM; without it each glyph is
+// scaled into a buffer on the stack every time it's drawn. the cache isn't
+// locked, so with it on print_scaled() mustn't run on two threads at once
+#ifndef LCD_SCALE_CACHE
+#define LCD_SCALE_CACHE 0
+#endif
+
+// largest glyph print_scaled() draws a byte at a time, and the size of each
+// cache entry. enough for the built in font at 4x, bigger glyphs are drawn a
+// pixel at a time
+#ifndef LCD_SCALE_BYTES
+#define LCD_SCALE_BYTES 80
+#endif
+
 #define LCD_WIDTH 84
 #define LCD_HEIGHT 48
 #define LCD_BANKS 6
 #define LCD_BYTES 504
 
+// most RAM one Nokia5110 takes, not counting a transport passed to its
+// constructor. about 580 bytes on a 32-bit target with the defaults. the pin
+// constructor keeps its Nokia5110SPI inside the instance, which adds
+// sizeof(Nokia5110SPI). checked at compile time
+#define LCD_INSTANCE_BYTES (LCD_BYTES * (1 + LCD_DOUBLE_BUFFER + LCD_SHADOW_BUFFER) + 64 * (1 + LCD_STATS) + 16 * sizeof(void *))
+
+// most static RAM print_scaled()'s cache takes, on top of LCD_INSTANCE_BYTES.
+// there is one cache however many canvases there are. about 96 bytes an entry
+// with the defaults, checked at compile time
+#define LCD_SCALE_CACHE_BYTES (LCD_SCALE_CACHE * (LCD_SCALE_BYTES + 8 + 2 * sizeof(void *)))
+
+// most bank spans a column from y = 0 to 255 can be split into
+#define LCD_MAX_SPANS 33
+
 #define LCD_POWERDOWN 0x04
 #define LCD_ENTRYMODE 0x02
 #define LCD_EXTENDEDINSTRUCTION 0x01
@@ -62,21 +163,26 @@
 #define LCD_SETBIAS 0x10
 #define LCD_SETVOP 0x80
 
+// controller state that hasn't been set since the last reset
+#define LCD_STATE_UNKNOWN 0xFF
+
 typedef uint8_t pattern_t[8];
 
 /**
- * @brief An API for using the Nokia 5110 display or other PCD8544-based
- * displays with mbed-os
- * @details The Nokia 5110 display is a 84x48 pixel single-bit LCD using the
- * PCD8544 controller.
- *  It is controlled by a modified version of the SPI protox.
- *
- *  If the API or test files dont work at first, try changing the contrast
- * setting. Different units
- *   will work best at different values. I've had this value range from 40 to 80
+ * @brief A 1bpp image in the PCD8544's bank format, and the primitives that
+ * draw on it
+ * @details The image is split into banks of 8 rows. Each bank is stored as
+ * one byte per column, with the top row in the least significant bit, which
+ * is the layout of the display's memory. Bank b of column x is at
+ * x + b * width.
  *
+ *  A canvas doesn't own its memory, the classes built on it do. Nokia5110
+ *  draws on an 84x48 canvas and sends it to one display, Nokia5110Tiled
+ *  draws on a canvas that is spread across several, and Nokia5110Surface is
+ *  a canvas that isn't sent anywhere, to be copied onto others with blit().
+ *  Coordinates are 8 bits, so a canvas is at most 255x255
  */
-class Nokia5110 {
+class Nokia5110Canvas {
 public:
     /**
      * @brief Mode for drawing pixels
@@ -92,12 +198,72 @@ public:
         pixel_nclr = 0x7
     };
 
-    // patterns
-    static const pattern_t pattern_black;
-    static const pattern_t pattern_dkgrey;
-    static const pattern_t pattern_grey;
-    static const pattern_t pattern_ltgrey;
-    static const pattern_t pattern_white;
+    /**
+     * @brief A fill pattern, stored as column bytes
+     * @details an 8x8 pattern_t is row-major, one byte per row with column 0
+     * in the least significant bit. a Pattern holds the same pattern as one
+     * byte per column with row 0 in the least significant bit, which lines up
+     * with the rows of a bank, so drawing a patterned byte is one lookup.
+     *
+     * The conversion is done once, when the Pattern is constructed. It's
+     * constexpr, so patterns defined as constants are converted at compile
+     * time. A pattern_t passed where a Pattern is expected is converted on
+     * every call, so define a Pattern for patterns that are used often.
+     *
+     * A screen anchored pattern lines up with pixel (0, 0) of the screen, so
+     * neighbouring shapes continue the same pattern. A shape anchored pattern
+     * starts at the top left corner of each shape's bounding box.
+     */
+    struct Pattern {
+        /**
+         * @brief where a pattern's origin is
+         */
+        enum Anchor {
+            screen,
+            shape
+        };
+
+        uint8_t columns[8]; // column x % 8 of the pattern, row 0 in bit 0
+        Anchor anchor;
+
+        /**
+         * @brief converts a row-major pattern
+         *
+         * @param rows pattern to convert
+         * @param anchor where the pattern's origin is
+         */
+        constexpr Pattern(const pattern_t rows, Anchor anchor = screen)
+            : columns{column(rows, 0), column(rows, 1), column(rows, 2), column(rows, 3),
+                      column(rows, 4), column(rows, 5), column(rows, 6), column(rows, 7)},
+              anchor(anchor) {}
+
+        /**
+         * @brief gets the pattern as it's drawn for a shape
+         *
+         * @param x left edge of the shape's bounding box
+         * @param y top edge of the shape's bounding box
+         *
+         * @return a screen anchored pattern, the pattern itself if it's
+         * already screen anchored
+         */
+        Pattern anchored(uint8_t x, uint8_t y) const;
+
+    private:
+        // rows `y` to 7 of column x of a row-major pattern
+        static constexpr uint8_t column(const pattern_t rows, uint8_t x, uint8_t y = 0) {
+            return (y == 8) ? 0 : (uint8_t) ((((rows[y] >> x) & 1) << y) | column(rows, x, y + 1));
+        }
+    };
+
+    // patterns, defined constexpr so they stay in flash
+    static const Pattern pattern_black;
+    static const Pattern pattern_dkgrey;
+    static const Pattern pattern_grey;
+    static const Pattern pattern_ltgrey;
+    static const Pattern pattern_white;
+
+    // the built in fixed width 5x7 font, 6 columns per character
+    static const Nokia5110Font font_5x7;
 
     /**
      * @brief Mode for filling shapes
@@ -112,124 +278,104 @@ public:
     };
 
     /**
-     * @brief constructor
-     *
-     * @param sce Chip Enable pin
-     * @param rst Reset pin
-     * @param dc D/C pin
-     * @param dn data pin (MOSI)
-     * @param sclk clock pin (SCLK)
-     */
-    Nokia5110(PinName sce, PinName rst, PinName dc, PinName dn, PinName sclk);
-
-    /**
-     * @brief initialize the display with given contrast and bias.
-     *
-     * @param con contrast for the display
-     * @param bias bias for the display, should be 0x04 for the nokia 5110
-     * display. only change for other PCD8544 displays
-     */
-    void init(uint8_t con = 40, uint8_t bias = 0x04);
-
-    /**
-     * @brief reset the display's memory
-     */
-    void reset();
-
-    /**
-     * @brief send a command to the display
-     *
-     * @param cmd command to send
-     */
-    void send_command(uint8_t cmd);
-
-    /**
-     * @brief send a byte of data to the display
+     * @brief gets the width of the canvas
      *
-     * @param data data to send
+     * @return width in pixels
      */
-    void send_data(uint8_t data);
+    uint8_t width() const {
+        return _width;
+    }
 
     /**
-     * @brief sets the display's contrast
+     * @brief gets the height of the canvas
      *
-     * @param con contrast, usually between 40 and 60 depending on your
-     * display
+     * @return height in pixels
      */
-    void set_contrast(uint8_t con);
+    uint8_t height() const {
+        return _height;
+    }
 
     /**
-     * @brief sets the dispay's bias
-     *
-     * @param bias bias, should be 0x4 for the Nokia 5110 display
+     * @brief clears the screen buffer
      */
-    void set_bias(uint8_t bias);
+    void clear_buffer();
 
     /**
-     * @brief sets the display's display mode
+     * @brief scrolls a range of banks up by whole banks
+     * @details the banks are moved with one memmove, and the banks left at
+     * the bottom of the range are cleared. the clip rectangle is ignored
      *
-     * @param mode display mode (Blank, inverted, allon or normal)
+     * @param bank0 first bank of the range
+     * @param bank1 last bank of the range
+     * @param count number of banks to scroll by
      */
-    void set_mode(uint8_t mode);
+    void scroll_banks(uint8_t bank0, uint8_t bank1, uint8_t count = 1);
 
     /**
-     * @brief turns the display on or off
+     * @brief limits drawing to a rectangle of the screen
+     * @details everything outside the rectangle is clipped, including parts
+     * of shapes that overhang the edge of the screen. the clip rectangle is
+     * the whole screen until this is called. ignored if LCD_WRAPAROUND is set
      *
-     * @param pow power, 0 = off, 1 = on
+     * @param x0 column of the first corner
+     * @param y0 row of the first corner
+     * @param x1 column of the second corner
+     * @param y1 row of the second corner
      */
-    void set_power(uint8_t pow);
+    void set_clip(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
 
     /**
-     * @brief sets the X value of the cursor
-     *
-     * @param col x coordinate (0-83)
+     * @brief sets the clip rectangle back to the whole screen
      */
-    void set_column(uint8_t col);
+    void reset_clip();
 
     /**
-     * @brief sets the Y value of the cursor
+     * @brief draws a pixel to the screen buffer
      *
-     * @param bank memory bank (0-5)
+     * @param x x coordinate (0-83)
+     * @param y y coordinate (0-47)
+     * @param pattern pattern to use
+     * @param mode  draw mode (see above)
      */
-    void set_bank(uint8_t bank);
+    void draw_pixel(uint8_t x, uint8_t y, const pattern_t pattern, Mode mode = pixel_copy);
 
     /**
-     * @brief sets the X and Y values of the cursor
+     * @brief draws a pixel to the screen buffer
      *
-     * @param col x coordinate (0-83)
-     * @param bank memory bank (0-5)
-     */
-    void set_cursor(uint8_t col, uint8_t bank);
-
-    /**
-     * @brief clears the screen buffer
-     */
-    void clear_buffer();
-
-    /**
-     * @brief sends the screen buffer to the display
+     * @param x x coordinate (0-83)
+     * @param y y coordinate (0-47)
+     * @param pattern pattern to use, a shape anchored pattern starts at the
+     * pixel
+     * @param mode  draw mode (see above)
      */
-    void display();
+    void draw_pixel(uint8_t x, uint8_t y, const Pattern &pattern, Mode mode = pixel_copy);
 
     /**
      * @brief draws a pixel to the screen buffer
      *
      * @param x x coordinate (0-83)
      * @param y y coordinate (0-47)
-     * @param pattern pattern to use
+     * @param value pixel value. 0 = white, 1 = black in normal mode
      * @param mode  draw mode (see above)
      */
-    void draw_pixel(uint8_t x, uint8_t y, const pattern_t pattern, Mode mode = pixel_copy);
+    void draw_pixel(uint8_t x, uint8_t y, bool value, Mode mode = pixel_copy);
 
     /**
-     * @brief draws a pixel to the screen buffer
+     * @brief draws a pixel to the screen buffer, with the draw mode fixed at
+     * compile time
+     * @details the templated primitives resolve the mode's inversion and
+     * combining when they're compiled, so their inner loops are a single
+     * bitwise operation. they're instantiated for every Mode in
+     * Nokia5110.cpp, and the primitives taking a runtime Mode pick one from a
+     * table, once per call
      *
+     * @tparam M draw mode (see above)
      * @param x x coordinate (0-83)
      * @param y y coordinate (0-47)
      * @param value pixel value. 0 = white, 1 = black in normal mode
-     * @param mode  draw mode (see above)
      */
-    void draw_pixel(uint8_t x, uint8_t y, bool value, Mode mode = pixel_copy);
+    template <Mode M>
+    void draw_pixel(uint8_t x, uint8_t y, bool value);
 
     /**
      * @brief gets the value of a pixel from the screen buffer
@@ -261,7 +407,39 @@ public:
     uint8_t get_byte(uint8_t x, uint8_t y);
 
     /**
-     * @brief prints a 7x5 character
+     * @brief sets the font print_char() and print_string() use
+     *
+     * @param font font to use, must stay valid while it's in use. NULL for
+     * the built in 5x7 font
+     */
+    void set_font(const Nokia5110Font *font);
+
+    /**
+     * @brief gets the font print_char() and print_string() use
+     */
+    const Nokia5110Font *get_font() const {
+        return _font;
+    }
+
+    /**
+     * @brief gets the width of a string in the current font
+     *
+     * @param str string to measure
+     * @param chars maximum number of chars to measure.
+     *        -1 = no limit. stops at null byte
+     *
+     * @return columns print_string() would advance by, including the spacing
+     * after the last character
+     */
+    unsigned int text_width(const char *str, int8_t chars = -1) const;
+
+    /**
+     * @brief prints a character in the current font
+     * @details each column of the glyph is written as a byte for every 8
+     * rows of the font, or as two shifted bytes if y isn't a multiple of 8.
+     * the whole cell is drawn, including the blank columns a proportional
+     * font doesn't store, so pixel_copy covers what was there before.
+     * characters the font doesn't have are drawn as its first character
      *
      * @param c character to draw
      * @param x x coordinate of upper left (0-83)
@@ -273,19 +451,41 @@ public:
     uint8_t print_char(char c, uint8_t x, uint8_t y, Mode mode = pixel_copy);
 
     /**
-     * @brief prints a string
+     * @brief prints a string in the current font
      *
      * @param str string to print
      * @param x x coordinate of upper left (0-83)
      * @param y y coordinate of upper left (0-47)
      * @param chars maximum number of chars to print.
-     *        -1 = no limit. stops at null byte
+     *        -1 = no limit. stops at null byte, or before the first character
+     *        that doesn't fit on the screen
      * @param mode  draw mode (see above)
      *
      * @return next column to print to
      */
     uint8_t print_string(const char *str, uint8_t x, uint8_t y, int8_t chars = -1, Mode mode = pixel_copy);
 
+    /**
+     * @brief prints a string in the current font, scaled up
+     * @details each pixel of the font is drawn as a scale x scale block.
+     * glyph bytes are spread out into bank bytes with lookup tables. if
+     * LCD_SCALE_CACHE is set, the last LCD_SCALE_CACHE glyphs drawn are kept
+     * scaled, so redrawing a number that changes costs little more than
+     * copying its bytes. the cache is shared by every canvas and isn't
+     * locked, so print_scaled() mustn't be called from two threads at once
+     * when it's on
+     *
+     * @param str string to print
+     * @param x x coordinate of upper left (0-83)
+     * @param y y coordinate of upper left (0-47)
+     * @param scale 1-4, larger scales are drawn at 4. 1 is the same as
+     * print_string()
+     * @param mode  draw mode (see above)
+     *
+     * @return next column to print to
+     */
+    uint8_t print_scaled(const char *str, uint8_t x, uint8_t y, uint8_t scale, Mode mode = pixel_copy);
+
     /**
      * @brief draws a bitmap in an unpadded format
      *
@@ -297,17 +497,114 @@ public:
      */
     void draw_bitmap(const uint8_t *bmp, uint8_t x, uint8_t y, uint8_t width, uint8_t height, Mode mode = pixel_copy);
 
+    /**
+     * @brief draws a bitmap in the native bank format
+     * @details whole bytes are copied or combined into the screen buffer,
+     * shifted across two banks if y isn't a multiple of 8
+     *
+     * @param data bitmap data, see NativeBitmap
+     * @param x x coordinate of upper left (0-83)
+     * @param y y coordinate of upper left (0-47)
+     * @param width bitmap width in pixels
+     * @param height bitmap height in pixels
+     * @param mode  draw mode (see above)
+     */
+    void draw_native_bitmap(const uint8_t *data, uint8_t x, uint8_t y, uint8_t width, uint8_t height, Mode mode = pixel_copy);
+
+    /**
+     * @brief draws a bitmap in the native bank format
+     *
+     * @param bmp bitmap to draw, see to_native_bitmap()
+     * @param x x coordinate of upper left (0-83)
+     * @param y y coordinate of upper left (0-47)
+     * @param mode  draw mode (see above)
+     */
+    template <unsigned int W, unsigned int H>
+    void draw_native_bitmap(const NativeBitmap<W, H> &bmp, uint8_t x, uint8_t y, Mode mode = pixel_copy) {
+        draw_native_bitmap(bmp.data, x, y, W, H, mode);
+    }
+
+    /**
+     * @brief copies part of another canvas onto this one
+     * @details src can be this canvas, and the two rectangles can overlap.
+     * whole bytes are shifted between banks, so the rows of a bank are
+     * copied together whatever y is. parts that land outside the clip
+     * rectangle are clipped
+     *
+     * @param src canvas to copy from, such as a Nokia5110Surface
+     * @param x0 column of the first corner of the source rectangle
+     * @param y0 row of the first corner of the source rectangle
+     * @param x1 column of the second corner of the source rectangle
+     * @param y1 row of the second corner of the source rectangle
+     * @param x column the rectangle's upper left corner is copied to, can be
+     * negative
+     * @param y row the rectangle's upper left corner is copied to, can be
+     * negative
+     * @param mode  draw mode (see above)
+     */
+    void blit(const Nokia5110Canvas &src, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1,
+              int16_t x, int16_t y, Mode mode = pixel_copy);
+
+    /**
+     * @brief copies part of another canvas onto this one, with the draw mode
+     * fixed at compile time
+     *
+     * @tparam M draw mode (see above)
+     */
+    template <Mode M>
+    void blit(const Nokia5110Canvas &src, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, int16_t x, int16_t y);
+
     /**
      * @brief draws a bitmap in the WBMP format
+     * @details parts of the image past the edge of the screen are clipped
      *
      * @param wbmp pointer to the start of the bitmap
      * @param x x coordinate of upper left (0-83)
      * @param y y coordinate of upper left (0-47)
+     * @param mode  draw mode (see above)
+     *
+     * @return true if the image was drawn, false if its header isn't valid
+     */
+    bool draw_wbitmap(const uint8_t *wbmp, uint8_t x, uint8_t y, Mode mode = pixel_copy);
+
+    /**
+     * @brief draws a bitmap in the WBMP format from a stream
+     * @details the image is decoded one row at a time, so it can be much
+     * larger than the screen or RAM. rows and columns outside the screen are
+     * skipped without being decoded, and reading stops after the last row
+     * that's visible. x and y can be negative to pan across a large image
+     *
+     * @param read callback that pulls image data, see lcd_read_t
+     * @param ctx context passed to read
+     * @param x x coordinate of upper left of the image on the screen
+     * @param y y coordinate of upper left of the image on the screen
+     * @param mode  draw mode (see above)
+     *
+     * @return true if the image was drawn, false if its header isn't valid or
+     * the stream ended early
+     */
+    bool draw_wbitmap(lcd_read_t read, void *ctx, int16_t x, int16_t y, Mode mode = pixel_copy);
+
+    /**
+     * @brief draws a bitmap in the WBMP format from a file
+     * @details see draw_wbitmap(lcd_read_t, void *, int16_t, int16_t, Mode).
+     * reads from the current position, and uses fseek to skip data
+     *
+     * @param file file to read the image from
+     * @param x x coordinate of upper left of the image on the screen
+     * @param y y coordinate of upper left of the image on the screen
+     * @param mode  draw mode (see above)
+     *
+     * @return true if the image was drawn, false if its header isn't valid or
+     * the file ended early
      */
-    void draw_wbitmap(const uint8_t *wbmp, uint8_t x, uint8_t y, Mode mode = pixel_copy);
+    bool draw_wbitmap(FILE *file, int16_t x, int16_t y, Mode mode = pixel_copy);
 
     /**
      * @brief draws a line
+     * @details the line is cut into runs along its major axis. steep lines
+     * are drawn as vertical runs of masked bytes, shallow lines as horizontal
+     * runs along a single row
      *
      * @param x0 x coordinate of first point
      * @param y0 y coordinate of first point
@@ -316,9 +613,17 @@ public:
      * @param mode  draw mode (see above)
      */
     void draw_line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1,
-                   const pattern_t pattern = pattern_black,
+                   const Pattern &pattern = pattern_black,
                    Mode mode = pixel_copy);
 
+    /**
+     * @brief draws a line, with the draw mode fixed at compile time
+     *
+     * @tparam M draw mode (see above)
+     */
+    template <Mode M>
+    void draw_line(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, const Pattern &pattern = pattern_black);
+
     /**
      * @brief draws a horizontal line
      *
@@ -328,11 +633,22 @@ public:
      * @param mode  draw mode (see above)
      */
     void draw_hline(uint8_t x0, uint8_t x1, uint8_t y,
-                    const pattern_t pattern = pattern_black,
+                    const Pattern &pattern = pattern_black,
                     Mode mode = pixel_copy);
 
+    /**
+     * @brief draws a horizontal line, with the draw mode fixed at compile time
+     *
+     * @tparam M draw mode (see above)
+     */
+    template <Mode M>
+    void draw_hline(uint8_t x0, uint8_t x1, uint8_t y, const Pattern &pattern = pattern_black);
+
     /**
      * @brief draws a vertical line
+     * @details the line is drawn a byte at a time, with one masked write for
+     * each bank it crosses. the filled circles, ellipses and rounded
+     * rectangles are all drawn out of vertical lines
      *
      * @param y0 y coordinate of first point
      * @param y1 y coordinate of second point
@@ -340,9 +656,17 @@ public:
      * @param mode  draw mode (see above)
      */
     void draw_vline(uint8_t y0, uint8_t y1, uint8_t x,
-                    const pattern_t pattern = pattern_black,
+                    const Pattern &pattern = pattern_black,
                     Mode mode = pixel_copy);
 
+    /**
+     * @brief draws a vertical line, with the draw mode fixed at compile time
+     *
+     * @tparam M draw mode (see above)
+     */
+    template <Mode M>
+    void draw_vline(uint8_t y0, uint8_t y1, uint8_t x, const Pattern &pattern = pattern_black);
+
     /**
      * @brief draws an empty rectangle
      *
@@ -354,7 +678,7 @@ public:
      * @param mode  draw mode (see above)
      */
     void draw_rect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1,
-                   const pattern_t pattern = pattern_black,
+                   const Pattern &pattern = pattern_black,
                    Mode mode = pixel_copy);
 
     /**
@@ -368,9 +692,17 @@ public:
      * @param mode  draw mode (see above)
      */
     void fill_rect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1,
-                   const pattern_t pattern = pattern_black,
+                   const Pattern &pattern = pattern_black,
                    Mode mode = pixel_copy);
 
+    /**
+     * @brief fills a rectangle, with the draw mode fixed at compile time
+     *
+     * @tparam M draw mode (see above)
+     */
+    template <Mode M>
+    void fill_rect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, const Pattern &pattern = pattern_black);
+
     /**
      * @brief draws an empty rounded rectangle
      *
@@ -383,7 +715,7 @@ public:
      * @param mode  draw mode (see above)
      */
     void draw_rrect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t r,
-                    const pattern_t pattern = pattern_black,
+                    const Pattern &pattern = pattern_black,
                     Mode mode = pixel_copy);
 
     /**
@@ -398,7 +730,7 @@ public:
      * @param mode  draw mode (see above)
      */
     void fill_rrect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, uint8_t r,
-                    const pattern_t pattern = pattern_black,
+                    const Pattern &pattern = pattern_black,
                     Mode mode = pixel_copy);
 
     /**
@@ -411,7 +743,7 @@ public:
      * @param mode  draw mode (see above)
      */
     void draw_circle(uint8_t cx, uint8_t cy, uint8_t r,
-                     const pattern_t pattern = pattern_black,
+                     const Pattern &pattern = pattern_black,
                      Mode mode = pixel_copy);
 
     /**
@@ -424,7 +756,7 @@ public:
      * @param mode  draw mode (see above)
      */
     void fill_circle(uint8_t cx, uint8_t cy, uint8_t r,
-                     const pattern_t pattern = pattern_black,
+                     const Pattern &pattern = pattern_black,
                      Mode mode = pixel_copy);
 
     /**
@@ -438,7 +770,7 @@ public:
      * @param mode  draw mode (see above)
      */
     void draw_ellipse(uint8_t cx, uint8_t cy, uint8_t a, uint8_t b,
-                      const pattern_t pattern = pattern_black,
+                      const Pattern &pattern = pattern_black,
                       Mode mode = pixel_copy);
 
     /**
@@ -452,18 +784,933 @@ public:
      * @param mode  draw mode (see above)
      */
     void fill_ellipse(uint8_t cx, uint8_t cy, uint8_t a, uint8_t b,
-                      const pattern_t = pattern_black,
+                      const Pattern &pattern = pattern_black,
                       Mode mode = pixel_copy);
 
+protected:
+    /**
+     * @brief constructor, the canvas starts out dirty with no clip rectangle
+     *
+     * @param buffer memory for the image, width * ceil(height / 8) bytes
+     * @param width width in pixels
+     * @param height height in pixels, a multiple of 8 if LCD_WRAPAROUND is
+     * set, since wrapped rows have to keep their bit in the bank
+     * @param dirty_x0 memory for the dirty tracker, one byte per bank
+     * @param dirty_x1 memory for the dirty tracker, one byte per bank
+     * @param clip_rows memory for the clip rectangle, one byte per bank
+     */
+    Nokia5110Canvas(uint8_t *buffer, uint8_t width, uint8_t height,
+                    uint8_t *dirty_x0, uint8_t *dirty_x1, uint8_t *clip_rows);
+
+    // no copying, the memory usually belongs to the derived class
+    Nokia5110Canvas(const Nokia5110Canvas &) = delete;
+    Nokia5110Canvas &operator=(const Nokia5110Canvas &) = delete;
+
+    /**
+     * @brief sets the dirty tracker to cover the whole canvas (dirty = true)
+     * or none of it (dirty = false)
+     */
+    void set_dirty(bool dirty);
+
+    /**
+     * @brief records that a byte of the canvas has been drawn to
+     *
+     * @param col column of the byte
+     * @param bank memory bank of the byte
+     */
+    void mark_dirty(uint8_t col, uint8_t bank) {
+        if (col < _dirty_x0[bank]) {
+            _dirty_x0[bank] = col;
+        }
+        if (col > _dirty_x1[bank]) {
+            _dirty_x1[bank] = col;
+        }
+    }
+
+    uint8_t *_buffer; // drawn to
+    uint8_t _width;
+    uint8_t _height;
+    uint8_t _banks; // banks of 8 rows, the last may be partly used
+    uint8_t *_dirty_x0; // first dirty column of each bank
+    uint8_t *_dirty_x1; // last dirty column of each bank, < x0 if clean
+#if LCD_STATS
+    uint32_t _pixels; // draw_pixel calls
+#endif
+
 private:
-    SPI *_lcd_SPI;
+    /**
+     * @brief applies a draw mode to some of the bits of a byte in the screen
+     * buffer
+     *
+     * @param col column of the byte (0-83)
+     * @param bank memory bank of the byte (0-5)
+     * @param mask bits to draw to
+     * @param bits pixel values, 1 = black in normal mode
+     * @param mode draw mode
+     */
+    void apply_byte(uint8_t col, uint8_t bank, uint8_t mask, uint8_t bits, Mode mode);
+
+    /**
+     * @brief applies draw mode M to some of the bits of a byte in the screen
+     * buffer
+     */
+    template <Mode M>
+    void apply_byte(uint8_t col, uint8_t bank, uint8_t mask, uint8_t bits);
+
+    /**
+     * @brief combines bits into a byte with draw mode M
+     * @details M is a constant, so this compiles down to one bitwise
+     * operation
+     *
+     * @param byte byte to draw to
+     * @param mask bits to draw to
+     * @param bits pixel values, 1 = black in normal mode
+     */
+    template <Mode M>
+    static void combine(uint8_t &byte, uint8_t mask, uint8_t bits);
+
+    /**
+     * @brief draws a horizontal run of pixels in one row
+     *
+     * @param x column of the first pixel
+     * @param y row of the run
+     * @param len number of pixels
+     * @param step direction of the run, 1 or -1. x wraps at 256
+     * @param pattern pattern to use
+     */
+    template <Mode M>
+    void draw_row_run(uint8_t x, uint8_t y, unsigned int len, int8_t step, const Pattern &pattern);
+
+    /**
+     * @brief draws a vertical run of pixels in one column
+     *
+     * @param x column of the run
+     * @param y row of the first pixel
+     * @param len number of pixels
+     * @param step direction of the run, 1 or -1. y wraps at 256
+     * @param pattern pattern to use
+     */
+    template <Mode M>
+    void draw_column_run(uint8_t x, uint8_t y, unsigned int len, int8_t step, const Pattern &pattern);
+
+    /**
+     * @brief draws rows y0 to y1 of a column, one masked byte per bank
+     *
+     * @param x column to draw in
+     * @param y0 first row
+     * @param y1 last row, y1 >= y0
+     * @param reverse draw the banks bottom to top, so pixels that wrap onto
+     * each other end up the same as drawing them from y1 to y0
+     * @param pattern pattern to use
+     */
+    template <Mode M>
+    void draw_column(uint8_t x, unsigned int y0, unsigned int y1, bool reverse, const Pattern &pattern);
+
+    /**
+     * @brief draws 8 rows of a column from a byte
+     *
+     * @param col column to draw in (0-83)
+     * @param y row of bit 0 (0-47). rows past the bottom wrap to the top, or
+     * are clipped if LCD_WRAPAROUND isn't set
+     * @param mask bits to draw
+     * @param bits pixel values, 1 = black in normal mode
+     * @param mode draw mode
+     */
+    void draw_column_byte(int16_t col, int16_t y, uint8_t mask, uint8_t bits, Mode mode);
+
+    /**
+     * @brief reads a WBMP multi-byte integer
+     *
+     * @return false if the stream ended or the value doesn't fit in 31 bits
+     */
+    static bool read_varint(lcd_read_t read, void *ctx, uint32_t *value);
+
+    /**
+     * @brief skips a WBMP's extension headers
+     *
+     * @param fix the image's fixed header byte
+     *
+     * @return false if the stream ended
+     */
+    static bool skip_extensions(lcd_read_t read, void *ctx, uint8_t fix);
 
-    DigitalOut *_sce;
-    DigitalOut *_rst;
-    DigitalOut *_dc;
+    /**
+     * @brief lcd_read_t that reads from memory, ctx points to the data pointer
+     */
+    static size_t read_memory(void *ctx, uint8_t *buf, size_t len);
 
-    uint8_t _buffer[LCD_BYTES];
-    static const uint8_t font[480];
+    /**
+     * @brief lcd_read_t that reads from a FILE, ctx is the FILE
+     */
+    static size_t read_file(void *ctx, uint8_t *buf, size_t len);
+
+    /**
+     * @brief splits a vertical run of rows into the banks it covers
+     *
+     * @param y0 first row, may be past the bottom of the screen
+     * @param y1 last row, y1 >= y0
+     * @param banks filled with the bank of each span
+     * @param masks filled with the bits of each span
+     *
+     * @return number of spans, at most LCD_MAX_SPANS
+     */
+    uint8_t column_spans(unsigned int y0, unsigned int y1, uint8_t *banks, uint8_t *masks);
+
+    /**
+     * @brief draws a pixel given in signed coordinates
+     * @details shapes are worked out in signed coordinates so the parts that
+     * overhang the edge of the screen can be clipped. with LCD_WRAPAROUND the
+     * coordinates are cut to 8 bits and wrapped, the way the shapes always
+     * have been
+     */
+    void clip_pixel(int16_t x, int16_t y, const Pattern &pattern, Mode mode);
+
+    /**
+     * @brief draws a pixel given in signed coordinates, see above
+     */
+    void clip_pixel(int16_t x, int16_t y, bool value, Mode mode);
+
+    /**
+     * @brief draws a horizontal line given in signed coordinates, see
+     * clip_pixel()
+     */
+    void clip_hline(int16_t x0, int16_t x1, int16_t y, const Pattern &pattern, Mode mode);
+
+    /**
+     * @brief draws a vertical line given in signed coordinates, see
+     * clip_pixel()
+     */
+    void clip_vline(int16_t y0, int16_t y1, int16_t x, const Pattern &pattern, Mode mode);
+
+    /**
+     * @brief fills a rectangle given in signed coordinates, see clip_pixel()
+     */
+    void clip_fill_rect(int16_t x0, int16_t y0, int16_t x1, int16_t y1, const Pattern &pattern, Mode mode);
+
+    /**
+     * @brief clips a line to a rectangle
+     * @details works on the line's Bresenham steps rather than its end
+     * points, so the clipped line draws exactly the pixels of the whole line
+     * that are inside the rectangle. the line is major steps long along its
+     * major axis, and the minor axis offset at step i is
+     * (minor * (i + 1) - 1) / major
+     *
+     * @param a0 start of the line on the major axis
+     * @param sa direction of the line on the major axis, 1 or -1
+     * @param lo_a first column or row of the rectangle on the major axis
+     * @param hi_a last column or row of the rectangle on the major axis
+     * @param b0 start of the line on the minor axis
+     * @param sb direction of the line on the minor axis, 1 or -1
+     * @param lo_b first column or row of the rectangle on the minor axis
+     * @param hi_b last column or row of the rectangle on the minor axis
+     * @param major length of the line on the major axis, > 0
+     * @param minor length of the line on the minor axis, 0 < minor <= major
+     * @param first set to the first step inside the rectangle
+     * @param last set to the last step inside the rectangle
+     *
+     * @return false if none of the line is inside the rectangle
+     */
+    static bool clip_line(int16_t a0, int8_t sa, int16_t lo_a, int16_t hi_a,
+                          int16_t b0, int8_t sb, int16_t lo_b, int16_t hi_b,
+                          int16_t major, int16_t minor, unsigned int *first, unsigned int *last);
+
+    /**
+     * @brief gets the screen column for an x coordinate
+     * @details only wraps with LCD_WRAPAROUND, otherwise the primitives have
+     * already clipped their coordinates to the screen
+     */
+    inline uint8_t wrap_x(unsigned int x) {
+#if LCD_WRAPAROUND
+        return x % _width;
+#else
+        return x;
+#endif
+    }
+
+    /**
+     * @brief gets the screen row for a y coordinate, see wrap_x()
+     */
+    inline uint8_t wrap_y(unsigned int y) {
+#if LCD_WRAPAROUND
+        return y % _height;
+#else
+        return y;
+#endif
+    }
+
+    uint8_t _clip_x0; // clip rectangle, inclusive
+    uint8_t _clip_y0;
+    uint8_t _clip_x1;
+    uint8_t _clip_y1;
+    uint8_t *_clip_rows; // rows of each bank inside the clip rectangle
+    const Nokia5110Font *_font; // font to print in
+    static const uint8_t font_5x7_data[480]; // constexpr, so it stays in flash
+
+    /**
+     * @brief finds where a character is stored in the current font
+     * @details fixed width fonts get a glyph made up from their width
+     *
+     * @param c character to find
+     *
+     * @return the character's glyph, or the first character's if the font
+     * doesn't have it
+     */
+    Nokia5110Glyph find_glyph(char c) const;
+
+    /**
+     * @brief draws a glyph with draw mode M, see print_char()
+     *
+     * @param data first byte of the glyph, in the Nokia5110Font format
+     * @param rle glyph is run length encoded
+     * @param glyph the glyph's columns. the offset is ignored
+     * @param height rows of the glyph
+     * @param x x coordinate of upper left
+     * @param y y coordinate of upper left
+     */
+    template <Mode M>
+    void draw_glyph(const uint8_t *data, bool rle, const Nokia5110Glyph &glyph, uint8_t height, uint8_t x, uint8_t y);
+
+    /**
+     * @brief scales a glyph of the current font up
+     * @details each source byte becomes scale bytes in the scale banks below
+     * it, repeated across scale columns
+     *
+     * @param glyph glyph to scale, from find_glyph()
+     * @param scale 2-4
+     * @param out set to the scaled glyph, without its blank columns, in the
+     * Nokia5110Font format. glyph.width * ceil(height / 8) * scale * scale
+     * bytes
+     */
+    void scale_glyph(const Nokia5110Glyph &glyph, uint8_t scale, uint8_t *out) const;
+
+    /**
+     * @brief gets a scaled glyph from the cache, scaling it if it isn't there
+     *
+     * @param c character the glyph is for
+     * @param glyph glyph to scale, from find_glyph()
+     * @param scale 2-4
+     * @param scratch LCD_SCALE_BYTES to scale into if the cache is off
+     *
+     * @return the scaled glyph, see scale_glyph()
+     */
+    const uint8_t *find_scaled(char c, const Nokia5110Glyph &glyph, uint8_t scale, uint8_t *scratch);
+
+#if LCD_SCALE_CACHE
+    /**
+     * @brief a glyph kept scaled by print_scaled()
+     */
+    struct ScaledGlyph {
+        const Nokia5110Font *font; // NULL if the entry is empty
+        char c;
+        uint8_t scale;
+        uint32_t used; // _scale_clock when the glyph was last drawn
+        uint8_t data[LCD_SCALE_BYTES];
+    };
+
+    static ScaledGlyph _scale_cache[LCD_SCALE_CACHE];
+    static uint32_t _scale_clock;
+
+    static_assert(sizeof(_scale_cache) <= LCD_SCALE_CACHE_BYTES, "LCD_SCALE_CACHE_BYTES is out of date");
+#endif
+    static const uint16_t spread[3][16]; // constexpr, so it stays in flash
+};
+
+/**
+ * @brief Drives one PCD8544 controller
+ * @details A panel sends an 84x48 window of a frame to the display. The
+ *  frame is in the canvas layout, and the window's banks are stride bytes
+ *  apart, so a panel can show part of a canvas that is wider than the
+ *  display. The panel keeps track of the controller's state so redundant
+ *  commands aren't sent, and queues commands so they go out in the same CE
+ *  window as the data that follows them.
+ *
+ *  All I/O goes through a Nokia5110Transport. Panels can share an SPI bus
+ *  if each has its own CE pin
+ */
+class Nokia5110Panel {
+public:
+#if LCD_STATS
+    /**
+     * @brief performance counters, see stats()
+     */
+    struct Stats {
+        uint32_t pixels; // draw_pixel calls
+        uint32_t data_bytes; // data bytes sent
+        uint32_t command_bytes; // command bytes sent
+        uint32_t selects; // times CE was asserted
+        uint32_t flushes; // calls to display() and friends
+        uint32_t flush_us[LCD_STATS_BUCKETS]; // histogram of flush times
+    };
+#endif
+
+    /**
+     * @brief constructor
+     *
+     * @param transport bus the display is connected to. must outlive the
+     * panel
+     * @param frame top left byte of the window to send
+     * @param stride bytes from one bank of the frame to the next
+     */
+    Nokia5110Panel(Nokia5110Transport &transport, const uint8_t *frame, unsigned int stride = LCD_WIDTH);
+
+    /**
+     * @brief destructor, waits for a display_async() transfer to finish
+     */
+    ~Nokia5110Panel();
+
+    /**
+     * @brief initialize the display with given contrast and bias.
+     *
+     * @param con contrast for the display
+     * @param bias bias for the display, should be 0x04 for the nokia 5110
+     * display. only change for other PCD8544 displays
+     */
+    void init(uint8_t con = 40, uint8_t bias = 0x04);
+
+    /**
+     * @brief reset the display's memory
+     */
+    void reset();
+
+    /**
+     * @brief send a command to the display
+     * @details any commands queued by set_column() and set_bank() are sent
+     * first, in the same transfer
+     *
+     * @param cmd command to send
+     */
+    void send_command(uint8_t cmd);
+
+    /**
+     * @brief send a byte of data to the display
+     *
+     * @param data data to send
+     */
+    void send_data(uint8_t data);
+
+    /**
+     * @brief send a block of data to the display in a single transfer
+     * @details D/C and CE are asserted once for the whole block, instead of
+     * once per byte like send_data(uint8_t)
+     *
+     * @param data pointer to the data to send
+     * @param len number of bytes to send
+     */
+    void send_data(const uint8_t *data, size_t len);
+
+    /**
+     * @brief sets the display's contrast
+     * @details the driver keeps track of the controller's state, so nothing
+     * is sent if the contrast is unchanged, and the controller is left in the
+     * extended instruction set until a basic command needs it switched back
+     *
+     * @param con contrast, usually between 40 and 60 depending on your
+     * display
+     */
+    void set_contrast(uint8_t con);
+
+    /**
+     * @brief sets the dispay's bias
+     *
+     * @param bias bias (0-7), should be 0x4 for the Nokia 5110 display.
+     * larger values are sent as 7
+     */
+    void set_bias(uint8_t bias);
+
+    /**
+     * @brief sets the display's display mode
+     *
+     * @param mode display mode (LCD_DISPLAYBLANK, LCD_DISPLAYNORMAL,
+     * LCD_DISPLAYALLON or LCD_DISPLAYINVERTED). larger values are sent as
+     * inverted
+     */
+    void set_mode(uint8_t mode);
+
+    /**
+     * @brief turns the display on or off
+     *
+     * @param pow power, 0 = off, 1 = on
+     */
+    void set_power(uint8_t pow);
+
+    /**
+     * @brief sets the X value of the cursor
+     * @details the command is queued and sent with the next data or command,
+     * and dropped if the cursor is already there
+     *
+     * @param col x coordinate (0-83)
+     */
+    void set_column(uint8_t col);
+
+    /**
+     * @brief sets the Y value of the cursor
+     * @details the command is queued and sent with the next data or command,
+     * and dropped if the cursor is already there
+     *
+     * @param bank memory bank (0-5)
+     */
+    void set_bank(uint8_t bank);
+
+    /**
+     * @brief sets the X and Y values of the cursor
+     *
+     * @param col x coordinate (0-83)
+     * @param bank memory bank (0-5)
+     */
+    void set_cursor(uint8_t col, uint8_t bank);
+
+    /**
+     * @brief sends the window to the display
+     * @details the window is sent as one burst, so D/C and CE are only
+     * toggled once per frame instead of once per byte. If LCD_SHADOW_BUFFER
+     * is enabled, only the runs of bytes that differ from what was last sent
+     * are transferred, with the cursor moved between runs
+     */
+    void display();
+
+    /**
+     * @brief sends a span of columns in each bank of the window
+     * @details the spans are sent either bank by bank with horizontal
+     * addressing, or as one column-ordered burst with vertical addressing,
+     * whichever takes fewer bytes on the bus
+     *
+     * @param x0 first column of each bank's span
+     * @param x1 last column of each bank's span, less than x0 to skip a bank
+     */
+    void display_banks(const uint8_t *x0, const uint8_t *x1);
+
+    /**
+     * @brief gets the bus the display is connected to
+     *
+     * @return the transport
+     */
+    Nokia5110Transport &transport() {
+        return *_transport;
+    }
+
+#if LCD_DOUBLE_BUFFER
+    /**
+     * @brief checks if display_async() is still sending a frame
+     *
+     * @return true if a frame is being sent
+     */
+    bool busy();
+#endif
+
+#if LCD_STATS
+    /**
+     * @brief gets the performance counters
+     * @details only available if LCD_STATS is enabled. flush times are
+     * measured with Nokia5110Transport::time_us(), and for display_async()
+     * run until the transfer completes
+     *
+     * @return counters since the last reset_stats()
+     */
+    const Stats &stats();
+
+    /**
+     * @brief zeros the performance counters
+     */
+    void reset_stats();
+#endif
+
+protected:
+    /**
+     * @brief sends the whole window
+     */
+    void display_full();
+
+#if LCD_SHADOW_BUFFER
+    /**
+     * @brief sends only the bytes that differ from the shadow buffer
+     */
+    void display_diff();
+#endif
+
+    /**
+     * @brief sends part of the window
+     *
+     * @param start address on the display of the first byte to send
+     * (col + bank * LCD_WIDTH)
+     * @param len number of bytes to send
+     */
+    void send_span(unsigned int start, unsigned int len);
+
+    /**
+     * @brief sends a span of columns in each bank, choosing horizontal or
+     * vertical addressing for whichever sends fewer bytes
+     *
+     * @param x0 first column of each bank's span
+     * @param x1 last column of each bank's span, less than x0 to skip a bank
+     */
+    void send_banks(const uint8_t *x0, const uint8_t *x1);
+
+    /**
+     * @brief sends part of the screen buffer using vertical addressing
+     *
+     * @param start address of the first byte to send, in column order
+     * (column * LCD_BANKS + bank)
+     * @param len number of bytes to send
+     */
+    void send_column_span(unsigned int start, unsigned int len);
+
+    /**
+     * @brief queues a switch to horizontal or vertical addressing, and to the
+     * basic instruction set
+     *
+     * @param vertical true for vertical addressing
+     */
+    void set_addressing(bool vertical);
+
+    /**
+     * @brief adds a command to the queue and updates the cached controller
+     * state to match
+     *
+     * @param cmd command to queue
+     */
+    void queue_command(uint8_t cmd);
+
+    /**
+     * @brief queues a FUNCTIONSET command if the controller isn't already set
+     * to the given function
+     *
+     * @param function power down, entry mode and extended instruction bits
+     */
+    void queue_function(uint8_t function);
+
+    /**
+     * @brief sends the queued commands in a single CE window
+     */
+    void flush_commands();
+
+    /**
+     * @brief writes the queued commands to the bus. CE must already be low
+     */
+    void write_commands();
+
+    /**
+     * @brief moves the cached cursor the way the controller auto-increments it
+     *
+     * @param len number of data bytes sent
+     */
+    void advance_cursor(size_t len);
+
+    /**
+     * @brief marks all cached controller state as unknown
+     */
+    void forget_state();
+
+    /**
+     * @brief gets the current function bits, or the power-on defaults if
+     * they are unknown
+     */
+    uint8_t function() {
+        return _function == LCD_STATE_UNKNOWN ? 0 : _function;
+    }
+
+#if LCD_DOUBLE_BUFFER
+    /**
+     * @brief starts sending a whole frame in the background
+     * @details the cursor must already be queued to (0, 0) with horizontal
+     * addressing
+     *
+     * @param frame LCD_BYTES bytes to send. must stay valid until done is
+     * called
+     * @param done called once the frame has been sent
+     */
+    void send_async(const uint8_t *frame, lcd_callback_t done);
+
+    /**
+     * @brief finishes a send_async() transfer
+     *
+     * @param panel the Nokia5110Panel object that started the transfer
+     */
+    static void flush_done(void *panel);
+
+    /**
+     * @brief waits for a display_async() transfer to finish
+     */
+    void wait_flush() {
+        while (_busy) {
+        }
+    }
+#endif
+
+    /**
+     * @brief sets the chip enable line, counting selects if LCD_STATS is
+     * enabled
+     *
+     * @param selected true to select the display
+     */
+    void select(bool selected) {
+#if LCD_STATS
+        _stats.selects += selected;
+#endif
+        _transport->select(selected);
+    }
+
+#if LCD_STATS
+    /**
+     * @brief counts a flush and adds its time to the histogram
+     *
+     * @param start time_us() when the flush started
+     */
+    void record_flush(uint32_t start);
+#endif
+
+    /**
+     * @brief finds a byte of the window in the frame
+     *
+     * @param addr address of the byte on the display (col + bank * LCD_WIDTH)
+     *
+     * @return pointer to the byte
+     */
+    const uint8_t *frame_at(unsigned int addr) const {
+        return _frame + addr % LCD_WIDTH + (addr / LCD_WIDTH) * _stride;
+    }
+
+    /**
+     * @brief asserts CE and D/C and writes out any queued commands, ready for
+     * data
+     */
+    void begin_data();
+
+    /**
+     * @brief writes data bytes between begin_data() and end_data()
+     *
+     * @param data bytes to write
+     * @param len number of bytes to write
+     */
+    void write_data(const uint8_t *data, size_t len);
+
+    /**
+     * @brief releases D/C and CE after begin_data()
+     *
+     * @param len total number of data bytes written, to move the cached
+     * cursor by
+     */
+    void end_data(size_t len);
+
+    Nokia5110Transport *_transport;
+    const uint8_t *_frame; // top left byte of the window
+    unsigned int _stride;
+
+#if LCD_STATS
+    Stats _stats;
+    uint32_t _async_start;
+#endif
+
+    uint8_t _cmd_queue[8];
+    uint8_t _cmd_len;
+
+    // cached controller state, LCD_STATE_UNKNOWN if not known
+    uint8_t _function; // power down, entry mode and extended instruction bits
+    uint8_t _x;
+    uint8_t _bank;
+    uint8_t _display_mode;
+    uint8_t _vop;
+    uint8_t _bias;
+
+#if LCD_DOUBLE_BUFFER
+    volatile bool _busy;
+    lcd_callback_t _flush_callback;
+#endif
+#if LCD_SHADOW_BUFFER
+    uint8_t _shadow[LCD_BYTES]; // copy of the display's RAM
+    bool _shadow_valid;
+#endif
+};
+
+#ifdef __MBED__
+/**
+ * @brief Holds the Nokia5110SPI made by Nokia5110's pin constructor
+ * @details Nokia5110 lists this as a base ahead of Nokia5110Panel, so the
+ *  transport is built before the panel is given it and destroyed after the
+ *  panel is done with it, without the heap.
+ */
+class Nokia5110SPIHolder {
+protected:
+    /**
+     * @brief constructor, for a Nokia5110 given its transport. holds nothing
+     */
+    Nokia5110SPIHolder();
+
+    /**
+     * @brief constructor, makes a Nokia5110SPI, see Nokia5110SPI()
+     */
+    Nokia5110SPIHolder(PinName sce, PinName rst, PinName dc, PinName dn, PinName sclk);
+
+    /**
+     * @brief destructor, destroys the Nokia5110SPI if there is one
+     */
+    ~Nokia5110SPIHolder();
+
+    Nokia5110SPIHolder(const Nokia5110SPIHolder &) = delete;
+    Nokia5110SPIHolder &operator=(const Nokia5110SPIHolder &) = delete;
+
+    alignas(Nokia5110SPI) uint8_t _transport_storage[sizeof(Nokia5110SPI)];
+    Nokia5110SPI *_own_transport; // made by the pin constructor, NULL otherwise
+};
+#endif
+
+/**
+ * @brief An API for using the Nokia 5110 display or other PCD8544-based
+ * displays with mbed-os
+ * @details The Nokia 5110 display is a 84x48 pixel single-bit LCD using the
+ * PCD8544 controller.
+ *  It is controlled by a modified version of the SPI protox.
+ *
+ *  All I/O goes through a Nokia5110Transport. On mbed-os the pin constructor
+ *  creates one for the SPI bus, on a host Nokia5110Emulator can be used to run
+ *  the driver against an emulated controller.
+ *
+ *  A Nokia5110 is an 84x48 Nokia5110Canvas with a Nokia5110Panel that shows
+ *  all of it. To spread one canvas across several displays, see
+ *  Nokia5110Tiled.
+ *
+ *  Nothing is allocated on the heap, so a Nokia5110 can be a global. It takes
+ *  at most LCD_INSTANCE_BYTES of RAM, plus the transport. If LCD_SCALE_CACHE
+ *  is set, print_scaled() also keeps a cache of up to LCD_SCALE_CACHE_BYTES,
+ *  once for the whole program rather than per display.
+ *
+ *  If the API or test files dont work at first, try changing the contrast
+ * setting. Different units
+ *   will work best at different values. I've had this value range from 40 to 80
+ *
+ */
+class Nokia5110 :
+#ifdef __MBED__
+    private Nokia5110SPIHolder,
+#endif
+    public Nokia5110Canvas, public Nokia5110Panel {
+public:
+    /**
+     * @brief constructor
+     *
+     * @param sce Chip Enable pin
+     * @param rst Reset pin
+     * @param dc D/C pin
+     * @param dn data pin (MOSI)
+     * @param sclk clock pin (SCLK)
+     */
+#ifdef __MBED__
+    Nokia5110(PinName sce, PinName rst, PinName dc, PinName dn, PinName sclk);
+#endif
+
+    /**
+     * @brief constructor
+     *
+     * @param transport bus the display is connected to. must outlive the
+     * Nokia5110 object
+     */
+    Nokia5110(Nokia5110Transport &transport);
+
+    /**
+     * @brief destructor, waits for a display_async() transfer to finish and
+     * releases the pins if the pin constructor was used
+     */
+    ~Nokia5110();
+
+    /**
+     * @brief initialize the display with given contrast and bias.
+     *
+     * @param con contrast for the display
+     * @param bias bias for the display, should be 0x04 for the nokia 5110
+     * display. only change for other PCD8544 displays
+     */
+    void init(uint8_t con = 40, uint8_t bias = 0x04);
+
+    /**
+     * @brief reset the display's memory
+     */
+    void reset();
+
+    /**
+     * @brief sends the screen buffer to the display
+     * @details the buffer is sent as one burst, so D/C and CE are only toggled
+     * once per frame instead of once per byte. This cuts the 2016 pin writes
+     * of a byte-at-a-time flush down to 4, leaving the flush bound by SPI
+     * wire time (504 bytes, about 10ms at LCD_SPI_FREQ)
+     *
+     * If LCD_SHADOW_BUFFER is enabled, only the runs of bytes that differ
+     * from what was last sent are transferred, with the cursor moved between
+     * runs. Writing to the display directly with send_data() will leave the
+     * shadow out of date; call reset() or init() to force a full flush
+     */
+    void display();
+
+#if LCD_DOUBLE_BUFFER
+    /**
+     * @brief starts sending the screen buffer to the display in the
+     * background
+     * @details the buffer being drawn to and the buffer being sent are
+     * swapped, and the new back buffer is loaded with a copy of the frame so
+     * drawing can carry on while the transfer runs. The transfer uses the
+     * event driven SPI API where the target supports it (DEVICE_SPI_ASYNCH),
+     * otherwise the frame is sent before returning (see
+     * Nokia5110Transport::write_async()). Other calls that talk to the
+     * display wait for the transfer to finish
+     *
+     * @param done called once the frame has been sent and the front buffer
+     * released. may be called from interrupt context
+     *
+     * @return false if a previous frame is still being sent
+     */
+    bool display_async(lcd_callback_t done = NULL);
+#endif
+
+    /**
+     * @brief sends a rectangular region of the screen buffer to the display
+     * @details rows of the region that span the full width are sent as a
+     * single transfer, and narrow regions that span the full height are sent
+     * as one burst using vertical addressing. the dirty tracker is not
+     * changed
+     *
+     * @param x0 first column (0-83)
+     * @param bank0 first memory bank (0-5)
+     * @param x1 last column (0-83)
+     * @param bank1 last memory bank (0-5)
+     */
+    void display_region(uint8_t x0, uint8_t bank0, uint8_t x1, uint8_t bank1);
+
+    /**
+     * @brief sends the parts of the screen buffer that were drawn to since the
+     * last flush
+     * @details every drawing call records the range of columns it touched in
+     * each memory bank. only those spans are sent, then the tracker is reset.
+     *
+     * The spans are sent either bank by bank with horizontal addressing, or
+     * as one column-ordered burst with vertical addressing, whichever takes
+     * fewer bytes on the bus
+     */
+    void display_dirty();
+
+#if LCD_STATS
+    /**
+     * @brief gets the performance counters
+     * @details only available if LCD_STATS is enabled. flush times are
+     * measured with Nokia5110Transport::time_us(), and for display_async()
+     * run until the transfer completes
+     *
+     * @return counters since the last reset_stats()
+     */
+    const Stats &stats();
+
+    /**
+     * @brief zeros the performance counters
+     */
+    void reset_stats();
+#endif
+
+private:
+#if LCD_DOUBLE_BUFFER
+    uint8_t _frames[2][LCD_BYTES];
+    uint8_t *_front; // front buffer, sent by display_async()
+#else
+    uint8_t _frames[1][LCD_BYTES];
+#endif
+    uint8_t _dirty_banks[2][LCD_BANKS]; // first and last dirty column of each bank
+    uint8_t _clip_banks[LCD_BANKS];
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+/*
+   Copyright 2017 Andrew Cassidy
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#ifndef NOKIA5110_BITMAP_H
+#define NOKIA5110_BITMAP_H
+
+#include <stdint.h>
+
+/**
+ * @brief A bitmap stored in the display's native bank format
+ * @details The bitmap is split into banks of 8 rows. Each bank is stored as
+ * one byte per column, with the top row in the least significant bit, which
+ * is the same layout as the display's memory. Drawing one only has to shift
+ * and combine whole bytes.
+ *
+ * Use to_native_bitmap() to convert a row-major bitmap (the format
+ * Nokia5110::draw_bitmap() takes) at compile time:
+ *
+ * @code
+ * constexpr uint8_t dog[51] = {...}; // 24x17, row-major, MSB first
+ * constexpr NativeBitmap<24, 17> dog_native = to_native_bitmap<24, 17>(dog);
+ * @endcode
+ */
+template <unsigned int W, unsigned int H>
+struct NativeBitmap {
+    uint8_t data[W * ((H + 7) / 8)]; // bank 0 columns, then bank 1 columns...
+};
+
+namespace nokia5110_detail {
+
+template <unsigned int... I>
+struct index_list {};
+
+// appends B to A, with B's indices moved up past the end of A
+template <class A, class B>
+struct join_index_lists;
+
+template <unsigned int... I, unsigned int... J>
+struct join_index_lists<index_list<I...>, index_list<J...>> {
+    typedef index_list<I..., (sizeof...(I) + J)...> type;
+};
+
+// 0 to N - 1, built from two halves so the template nesting is only log2(N)
+// deep, and large bitmaps stay under the compiler's instantiation depth limit
+template <unsigned int N>
+struct make_index_list
+    : join_index_lists<typename make_index_list<N / 2>::type, typename make_index_list<N - N / 2>::type> {};
+
+template <>
+struct make_index_list<0> {
+    typedef index_list<> type;
+};
+
+template <>
+struct make_index_list<1> {
+    typedef index_list<0> type;
+};
+
+// pixel (x, y) of a row-major, MSB first bitmap with no row padding
+constexpr uint8_t row_major_pixel(const uint8_t *bmp, unsigned int width, unsigned int x, unsigned int y) {
+    return (bmp[(y * width + x) / 8] >> (7 - (y * width + x) % 8)) & 1;
+}
+
+// bits `bit` to 7 of the byte for column x of a bank
+constexpr uint8_t native_byte(const uint8_t *bmp, unsigned int width, unsigned int height,
+                              unsigned int x, unsigned int bank, unsigned int bit = 0) {
+    return (bit == 8) ? 0 :
+           (uint8_t) ((((bank * 8 + bit) < height ? row_major_pixel(bmp, width, x, bank * 8 + bit) : 0) << bit) |
+                      native_byte(bmp, width, height, x, bank, bit + 1));
+}
+
+template <unsigned int W, unsigned int H, unsigned int... I>
+constexpr NativeBitmap<W, H> to_native_bitmap(const uint8_t *bmp, index_list<I...>) {
+    return NativeBitmap<W, H> {{native_byte(bmp, W, H, I % W, I / W)...}};
+}
+
+}
+
+/**
+ * @brief converts a row-major, MSB first bitmap to the native bank format
+ * @details usable in constant expressions, so the conversion can be done at
+ * compile time and only the converted bitmap ends up in flash
+ *
+ * @tparam W bitmap width in pixels
+ * @tparam H bitmap height in pixels
+ * @param bmp bitmap in the format taken by Nokia5110::draw_bitmap()
+ *
+ * @return the bitmap in the native bank format
+ */
+template <unsigned int W, unsigned int H>
+constexpr NativeBitmap<W, H> to_native_bitmap(const uint8_t *bmp) {
+    return nokia5110_detail::to_native_bitmap<W, H>(bmp, typename nokia5110_detail::make_index_list<W * ((H + 7) / 8)>::type());
+}
+
+#endif
@@ -0,0 +1,158 @@
+/*
+   Copyright 2017 Andrew Cassidy
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "Nokia5110Console.h"
+#include <stdio.h>
+#include <string.h>
+
+Nokia5110Console::Nokia5110Console(Nokia5110 &display, uint8_t bank0, uint8_t bank1)
+    : _display(display) {
+    _bank0 = bank0;
+    _bank1 = (bank1 < LCD_BANKS) ? bank1 : LCD_BANKS - 1;
+    _cols = display.width() / LCD_CONSOLE_CELL;
+    _col = 0;
+    _line = _bank0;
+}
+
+void Nokia5110Console::clear() {
+    _display.scroll_banks(_bank0, _bank1, _bank1 - _bank0 + 1);
+    _col = 0;
+    _line = _bank0;
+}
+
+void Nokia5110Console::set_cursor(uint8_t col, uint8_t line) {
+    _col = (col < _cols) ? col : _cols;
+    _line = (_bank0 + line <= _bank1) ? _bank0 + line : _bank1;
+}
+
+ssize_t Nokia5110Console::write(const void *buffer, size_t length) {
+    const char *chars = (const char *) buffer;
+
+    for (size_t i = 0; i < length; i++) {
+        put(chars[i]);
+    }
+
+    _display.display_dirty();
+    return length;
+}
+
+void Nokia5110Console::put(char c) {
+    switch (c) {
+    case '\n':
+        new_line();
+        return;
+    case '\r':
+        _col = 0;
+        return;
+    case '\t':
+        _col = (_col / LCD_CONSOLE_TAB + 1) * LCD_CONSOLE_TAB;
+        _col = (_col < _cols) ? _col : _cols;
+        return;
+    case '\b':
+        if (_col) {
+            _col--;
+        }
+        return;
+    default:
+        break;
+    }
+
+    // the font covers 0x20 to 0x7F
+    if ((uint8_t) c < 0x20 || (uint8_t) c > 0x7F) {
+        c = '?';
+    }
+
+    if (_col >= _cols) {
+        new_line();
+    }
+
+    // a newline on the bottom line only scrolls once there's something to
+    // put on the next line, so the bottom line isn't left empty
+    if (_line > _bank1) {
+        _display.scroll_banks(_bank0, _bank1);
+        _line = _bank1;
+    }
+
+    // the grid is laid out for the built in font, whatever the display is
+    // set to
+    const Nokia5110Font *font = _display.get_font();
+    _display.set_font(&Nokia5110::font_5x7);
+
+    uint8_t x = _col * LCD_CONSOLE_CELL;
+    _display.print_char(c, x, _line * 8);
+    _display.set_font(font);
+    if (x + 5 < _display.width()) {
+        _display.draw_byte(x + 5, _line, 0x00);
+    }
+    _col++;
+}
+
+void Nokia5110Console::new_line() {
+    if (_line > _bank1) {
+        _display.scroll_banks(_bank0, _bank1);
+        _line = _bank1;
+    }
+
+    _col = 0;
+    _line++;
+
+    if (_line <= _bank1) {
+        _display.scroll_banks(_line, _line); // clears it
+    }
+}
+
+#ifdef __MBED__
+int Nokia5110Console::_putc(int c) {
+    char ch = c;
+    write(&ch, 1);
+    return c;
+}
+
+int Nokia5110Console::_getc() {
+    return -1;
+}
+#else
+int Nokia5110Console::putc(int c) {
+    char ch = c;
+    write(&ch, 1);
+    return c;
+}
+
+int Nokia5110Console::puts(const char *str) {
+    write(str, strlen(str));
+    return 0;
+}
+
+int Nokia5110Console::printf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int len = vprintf(format, args);
+    va_end(args);
+
+    return len;
+}
+
+int Nokia5110Console::vprintf(const char *format, va_list args) {
+    char buffer[LCD_CONSOLE_PRINTF];
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+
+    if (len > 0) {
+        write(buffer, ((size_t) len < sizeof(buffer)) ? len : sizeof(buffer) - 1);
+    }
+
+    return len;
+}
+#endif
@@ -0,0 +1,164 @@
+/*
+   Copyright 2017 Andrew Cassidy
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#ifndef NOKIA5110_CONSOLE_H
+#define NOKIA5110_CONSOLE_H
+
+#include <stdarg.h>
+#include <sys/types.h>
+#include "Nokia5110.h"
+
+// columns of one character cell, 5 for the glyph and 1 between characters
+#define LCD_CONSOLE_CELL 6
+
+// columns a tab moves to a multiple of
+#define LCD_CONSOLE_TAB 4
+
+// longest printf() output on a host, in characters. a full screen is 84
+#define LCD_CONSOLE_PRINTF 128
+
+/**
+ * @brief A scrolling text console on a Nokia5110
+ * @details Text is laid out on a grid of 6x8 cells, one line per memory
+ * bank, 14 characters wide. Lines wrap at the right edge, and when the
+ * bottom line is full the console scrolls up a whole bank at a time with
+ * Nokia5110Canvas::scroll_banks(). '\n' starts a new line, '\r' goes back
+ * to the start of the line, '\t' moves to the next tab stop and '\b' moves
+ * back a character. Characters outside the font are shown as '?'.
+ *
+ *  Each write() ends with Nokia5110::display_dirty(), so only the lines it
+ *  changed are sent, or the whole console if it scrolled.
+ *
+ *  On mbed-os the console is a Stream, so it has printf(), and can take
+ *  over stdout:
+ *
+ * @code
+ * Nokia5110 display(p4, p3, p5, p6, p7);
+ * Nokia5110Console console(display);
+ *
+ * namespace mbed {
+ * FileHandle *mbed_override_console(int fd) {
+ *     return &console;
+ * }
+ * }
+ * @endcode
+ *
+ *  The console can be limited to a range of banks, so the rest of the
+ *  display can be drawn to as usual.
+ */
+class Nokia5110Console
+#ifdef __MBED__
+    : public Stream
+#endif
+{
+public:
+    /**
+     * @brief constructor
+     *
+     * @param display display to print to, must outlive the console. init()
+     * must be called on it before anything is printed
+     * @param bank0 first bank of the console
+     * @param bank1 last bank of the console
+     */
+    Nokia5110Console(Nokia5110 &display, uint8_t bank0 = 0, uint8_t bank1 = LCD_BANKS - 1);
+
+    /**
+     * @brief clears the console's banks and moves the cursor to the top left
+     */
+    void clear();
+
+    /**
+     * @brief moves the cursor
+     *
+     * @param col column, in characters
+     * @param line line, in characters from the top of the console
+     */
+    void set_cursor(uint8_t col, uint8_t line);
+
+    /**
+     * @brief prints characters and sends the lines that changed
+     *
+     * @param buffer characters to print
+     * @param length number of characters
+     *
+     * @return length
+     */
+    ssize_t write(const void *buffer, size_t length);
+
+#ifndef __MBED__
+    /**
+     * @brief prints a character
+     *
+     * @param c character to print
+     *
+     * @return c
+     */
+    int putc(int c);
+
+    /**
+     * @brief prints a string
+     *
+     * @param str null terminated string to print
+     *
+     * @return 0
+     */
+    int puts(const char *str);
+
+    /**
+     * @brief prints a formatted string, see printf(3). on mbed-os the Stream
+     * version is used
+     *
+     * @return number of characters printed
+     */
+    int printf(const char *format, ...);
+
+    /**
+     * @brief prints a formatted string, see vprintf(3)
+     *
+     * @return number of characters printed
+     */
+    int vprintf(const char *format, va_list args);
+#endif
+
+protected:
+#ifdef __MBED__
+    virtual int _putc(int c);
+    virtual int _getc();
+#endif
+
+private:
+    /**
+     * @brief prints a character without sending anything
+     *
+     * @param c character to print
+     */
+    void put(char c);
+
+    /**
+     * @brief moves to the start of the next line, scrolling if the cursor is
+     * on the bottom line, and clears it
+     */
+    void new_line();
+
+    Nokia5110 &_display;
+    uint8_t _bank0;
+    uint8_t _bank1;
+    uint8_t _cols;
+    uint8_t _col;
+    uint8_t _line; // bank the cursor is in
+};
+
+#endif
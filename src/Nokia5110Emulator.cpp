@@ -0,0 +1,174 @@
+/*
+   Copyright 2017 Andrew Cassidy
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "Nokia5110Emulator.h"
+#include <string.h>
+
+Nokia5110Emulator::Nokia5110Emulator() {
+    _selected = false;
+    _dc = false;
+    _bits = 0;
+    _delay_us = 0;
+
+    // the RAM isn't cleared by a reset, so fill it with something visible
+    memset(_ram, 0xA5, sizeof(_ram));
+
+    set_reset(true);
+    set_reset(false);
+    reset_counters();
+}
+
+void Nokia5110Emulator::select(bool selected) {
+    if (selected && !_selected) {
+        _selects++;
+    }
+    _selected = selected;
+}
+
+void Nokia5110Emulator::set_dc(bool data) {
+    _dc = data;
+}
+
+void Nokia5110Emulator::set_reset(bool asserted) {
+    _in_reset = asserted;
+
+    if (asserted) {
+        // state after a reset, from the PCD8544 datasheet
+        _function = LCD_POWERDOWN;
+        _x = 0;
+        _bank = 0;
+        _display_mode = LCD_DISPLAYBLANK;
+        _vop = 0;
+        _bias = 0;
+        _temp = 0;
+    }
+}
+
+void Nokia5110Emulator::write(const uint8_t *data, size_t len) {
+    _writes++;
+    _bits += len * 8;
+
+    if (!_selected || _in_reset) {
+        return; // the controller ignores the bus
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        if (_dc) {
+            this->data(data[i]);
+        } else {
+            command(data[i]);
+        }
+    }
+}
+
+void Nokia5110Emulator::delay_ms(unsigned int ms) {
+    _delay_us += ms * 1000;
+}
+
+uint32_t Nokia5110Emulator::time_us() {
+    return _delay_us + (_bits * 1000000) / LCD_SPI_FREQ;
+}
+
+const uint8_t *Nokia5110Emulator::ram() const {
+    return _ram;
+}
+
+bool Nokia5110Emulator::get_pixel(uint8_t x, uint8_t y) const {
+    return _ram[(x % LCD_WIDTH) + ((y % LCD_HEIGHT) / 8) * LCD_WIDTH] & (1 << (y % 8));
+}
+
+bool Nokia5110Emulator::get_visible(uint8_t x, uint8_t y) const {
+    if (powered_down()) {
+        return false;
+    }
+
+    switch (_display_mode) {
+    case LCD_DISPLAYNORMAL:
+        return get_pixel(x, y);
+    case LCD_DISPLAYINVERTED:
+        return !get_pixel(x, y);
+    case LCD_DISPLAYALLON:
+        return true;
+    default:
+    case LCD_DISPLAYBLANK:
+        return false;
+    }
+}
+
+void Nokia5110Emulator::print(FILE *out) const {
+    for (uint8_t y = 0; y < LCD_HEIGHT; y++) {
+        for (uint8_t x = 0; x < LCD_WIDTH; x++) {
+            fputc(get_visible(x, y) ? '#' : '.', out);
+        }
+        fputc('\n', out);
+    }
+}
+
+void Nokia5110Emulator::reset_counters() {
+    _data_bytes = 0;
+    _command_bytes = 0;
+    _selects = 0;
+    _writes = 0;
+}
+
+void Nokia5110Emulator::command(uint8_t cmd) {
+    _command_bytes++;
+
+    if ((cmd & 0xF8) == LCD_FUNCTIONSET) {
+        _function = cmd & 0x07;
+    } else if (_function & LCD_EXTENDEDINSTRUCTION) {
+        if (cmd & LCD_SETVOP) {
+            _vop = cmd & 0x7F;
+        } else if ((cmd & 0xF8) == LCD_SETBIAS) {
+            _bias = cmd & 0x07;
+        } else if ((cmd & 0xFC) == LCD_SETTEMP) {
+            _temp = cmd & 0x03;
+        }
+    } else {
+        if (cmd & LCD_SETXADDR) {
+            if ((cmd & 0x7F) < LCD_WIDTH) {
+                _x = cmd & 0x7F;
+            }
+        } else if ((cmd & 0xF8) == LCD_SETYADDR) {
+            if ((cmd & 0x07) < LCD_BANKS) {
+                _bank = cmd & 0x07;
+            }
+        } else if ((cmd & 0xFA) == LCD_DISPLAYCONTROL) {
+            _display_mode = cmd & 0x05;
+        }
+    }
+}
+
+void Nokia5110Emulator::data(uint8_t byte) {
+    _data_bytes++;
+    _ram[_x + _bank * LCD_WIDTH] = byte;
+
+    if (vertical()) {
+        if (++_bank == LCD_BANKS) {
+            _bank = 0;
+            if (++_x == LCD_WIDTH) {
+                _x = 0;
+            }
+        }
+    } else {
+        if (++_x == LCD_WIDTH) {
+            _x = 0;
+            if (++_bank == LCD_BANKS) {
+                _bank = 0;
+            }
+        }
+    }
+}
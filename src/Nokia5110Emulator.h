@@ -0,0 +1,141 @@
+/*
+   Copyright 2017 Andrew Cassidy
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#ifndef NOKIA5110_EMULATOR_H
+#define NOKIA5110_EMULATOR_H
+
+#include <stdio.h>
+#include "Nokia5110.h"
+#include "Nokia5110Transport.h"
+
+/**
+ * @brief A transport that emulates a PCD8544 controller in memory
+ * @details The command stream is decoded the way the controller would decode
+ * it, including the function set (power down, addressing mode and instruction
+ * set), the address pointer and its auto-increment, the display control and
+ * the extended VOP, bias and temperature settings. Data bytes land in an
+ * emulated 84x48 display RAM.
+ *
+ * This lets the whole driver run on a host, so what ends up on the glass and
+ * how many bytes it took to get there can be checked without hardware
+ */
+class Nokia5110Emulator : public Nokia5110Transport {
+public:
+    /**
+     * @brief constructor, the emulated controller starts out reset
+     */
+    Nokia5110Emulator();
+
+    virtual void select(bool selected);
+    virtual void set_dc(bool data);
+    virtual void set_reset(bool asserted);
+    virtual void write(const uint8_t *data, size_t len);
+    virtual void delay_ms(unsigned int ms);
+
+    /**
+     * @brief reads the emulated clock
+     * @details the clock only moves when bytes are written or delay_ms() is
+     * called, by the time it would take to clock the bytes out at
+     * LCD_SPI_FREQ. this makes flush timings deterministic on a host
+     *
+     * @return emulated time in microseconds
+     */
+    virtual uint32_t time_us();
+
+    /**
+     * @brief gets the contents of the emulated display RAM
+     *
+     * @return the display RAM, in the same layout as the driver's buffer
+     */
+    const uint8_t *ram() const;
+
+    /**
+     * @brief gets a pixel from the display RAM
+     *
+     * @param x x coordinate (0-83)
+     * @param y y coordinate (0-47)
+     *
+     * @return true if the pixel is set
+     */
+    bool get_pixel(uint8_t x, uint8_t y) const;
+
+    /**
+     * @brief gets a pixel as it would appear on the glass, taking the display
+     * mode and power down into account
+     *
+     * @param x x coordinate (0-83)
+     * @param y y coordinate (0-47)
+     *
+     * @return true if the pixel is dark
+     */
+    bool get_visible(uint8_t x, uint8_t y) const;
+
+    /**
+     * @brief prints what is on the glass as text, one character per pixel
+     *
+     * @param out file to print to
+     */
+    void print(FILE *out) const;
+
+    // decoded controller state
+    bool powered_down() const { return _function & 0x04; }
+    bool vertical() const { return _function & 0x02; }
+    bool extended() const { return _function & 0x01; }
+    uint8_t column() const { return _x; }
+    uint8_t bank() const { return _bank; }
+    uint8_t display_mode() const { return _display_mode; }
+    uint8_t vop() const { return _vop; }
+    uint8_t bias() const { return _bias; }
+    uint8_t temp() const { return _temp; }
+
+    // bus traffic since the last reset_counters()
+    unsigned long data_bytes() const { return _data_bytes; }
+    unsigned long command_bytes() const { return _command_bytes; }
+    unsigned long selects() const { return _selects; }
+    unsigned long writes() const { return _writes; }
+
+    /**
+     * @brief zeros the bus traffic counters
+     */
+    void reset_counters();
+
+private:
+    void command(uint8_t cmd);
+    void data(uint8_t byte);
+
+    bool _selected;
+    bool _dc;
+    bool _in_reset;
+
+    uint8_t _function;
+    uint8_t _x;
+    uint8_t _bank;
+    uint8_t _display_mode;
+    uint8_t _vop;
+    uint8_t _bias;
+    uint8_t _temp;
+
+    unsigned long _data_bytes;
+    unsigned long _command_bytes;
+    unsigned long _selects;
+    unsigned long _writes;
+    uint64_t _bits; // bits clocked out, drives the emulated clock
+    uint64_t _delay_us;
+
+    uint8_t _ram[LCD_BYTES];
+};
+
+#endif
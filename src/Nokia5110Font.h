@@ -0,0 +1,122 @@
+/*
+   Copyright 2017 Andrew Cassidy
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#ifndef NOKIA5110_FONT_H
+#define NOKIA5110_FONT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Where a glyph of a proportional font is stored, and how wide it is
+ * @details A glyph is a cell advance columns wide. Only the columns from
+ * left to left + width - 1 have any pixels set, the blank columns on either
+ * side aren't stored.
+ */
+struct Nokia5110Glyph {
+    uint16_t offset; // index of the glyph's first byte in the font data
+    uint8_t left; // blank columns before the first stored column
+    uint8_t width; // stored columns
+    uint8_t advance; // width of the cell, not counting the font's spacing
+};
+
+/**
+ * @brief A bitmap font
+ * @details Glyphs are stored as column bytes, the same layout as the
+ * display's banks: one byte per column for each 8 rows of the font's
+ * height, top row in the least significant bit, so a glyph is drawn by
+ * writing whole bytes. Like a NativeBitmap, a glyph of a font taller than 8
+ * rows stores the columns of its top 8 rows, then the columns of the next 8.
+ *
+ *  If glyphs is NULL the font is fixed width, every glyph is width columns
+ *  and they are stored one after another from first to last. Otherwise
+ *  glyphs has an entry for each character from first to last giving where
+ *  it is stored and how wide it is, with its blank columns trimmed off.
+ *
+ *  If rle is set, each glyph's bytes are run length encoded: a byte n below
+ *  0x80 is followed by n bytes to copy, and a byte 0x80 | n is followed by
+ *  one byte to repeat n times, with n from 1 to 127. A 0x00 or 0x80 byte is
+ *  skipped without reading anything after it. Compressed fonts must have a
+ *  glyph table.
+ *
+ *  Fonts are made from BDF files with tools/bdf2font.py, which writes them
+ *  out as constexpr tables so they stay in flash:
+ *
+ * @code
+ * #include "helv8.h" // python3 tools/bdf2font.py --rle helvR08.bdf helv8 > helv8.h
+ *
+ * display.set_font(&helv8);
+ * display.print_string("Proportional", 0, 0);
+ * display.set_font(NULL); // back to the built in 5x7 font
+ * @endcode
+ */
+struct Nokia5110Font {
+    const uint8_t *data; // glyph bytes
+    const Nokia5110Glyph *glyphs; // first to last, NULL if the font is fixed width
+    uint8_t first; // first character in the font
+    uint8_t last; // last character in the font
+    uint8_t width; // columns of every glyph if the font is fixed width, otherwise the widest advance
+    uint8_t height; // rows of every glyph, 1-255
+    uint8_t spacing; // blank columns left between glyphs, not drawn
+    bool rle; // glyph bytes are run length encoded
+};
+
+/**
+ * @brief Reads the bytes of one glyph in order, decompressing them if the
+ * font is run length encoded
+ */
+class Nokia5110GlyphReader {
+public:
+    /**
+     * @brief constructor
+     *
+     * @param data first byte of the glyph
+     * @param rle glyph is run length encoded
+     */
+    Nokia5110GlyphReader(const uint8_t *data, bool rle) {
+        _data = data;
+        _rle = rle;
+        _run = 0;
+        _repeat = false;
+    }
+
+    /**
+     * @brief gets the next byte of the glyph
+     */
+    inline uint8_t next() {
+        if (!_rle) {
+            return *_data++;
+        }
+
+        // empty runs are skipped, rather than wrapping the count
+        while (_run == 0) {
+            _run = *_data & 0x7F;
+            _repeat = *_data & 0x80;
+            _data++;
+        }
+
+        _run--;
+        return _repeat ? (_run ? *_data : *_data++) : *_data++;
+    }
+
+private:
+    const uint8_t *_data;
+    bool _rle;
+    uint8_t _run; // bytes left in the current run
+    bool _repeat; // the current run repeats one byte
+};
+
+#endif
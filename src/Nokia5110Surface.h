@@ -0,0 +1,76 @@
+/*
+   Copyright 2017 Andrew Cassidy
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#ifndef NOKIA5110_SURFACE_H
+#define NOKIA5110_SURFACE_H
+
+#include "Nokia5110.h"
+
+/**
+ * @brief An off-screen canvas
+ * @details A surface isn't connected to a display. Everything that can be
+ * drawn on a Nokia5110 can be drawn on a surface, and the result copied onto
+ * a display (or another surface) with Nokia5110Canvas::blit(), so menus and
+ * icons can be drawn once and composited as needed:
+ *
+ * @code
+ * Nokia5110Surface<32, 16> icon;
+ * icon.fill_rrect(0, 0, 31, 15, 3);
+ * icon.print_string("OK", 10, 4, -1, Nokia5110::pixel_xor);
+ *
+ * display.blit(icon, 0, 0, 31, 15, 26, 20);
+ * @endcode
+ *
+ *  The image is kept in the display's bank format, width * ceil(height / 8)
+ *  bytes, and starts out clear. With LCD_WRAPAROUND the height must be a
+ *  multiple of 8.
+ *
+ * @tparam W width in pixels
+ * @tparam H height in pixels
+ */
+template <uint8_t W, uint8_t H>
+class Nokia5110Surface : public Nokia5110Canvas {
+    static_assert(W > 0 && H > 0, "a surface must have at least one pixel");
+    // bytes are drawn whole, which only lines rows up with where they wrap to
+    // if every bank is full
+    static_assert(!LCD_WRAPAROUND || H % 8 == 0, "with LCD_WRAPAROUND, a surface's height must be a multiple of 8");
+
+public:
+    /**
+     * @brief constructor
+     */
+    Nokia5110Surface()
+        : Nokia5110Canvas(_data, W, H, _dirty_banks[0], _dirty_banks[1], _clip_banks), _data() {}
+
+    /**
+     * @brief gets the image
+     *
+     * @return W * ceil(H / 8) bytes in the bank format, see
+     * Nokia5110Canvas::draw_native_bitmap()
+     */
+    const uint8_t *data() const {
+        return _data;
+    }
+
+private:
+    static const uint8_t banks = (H + 7) / 8;
+
+    uint8_t _data[W * banks];
+    uint8_t _dirty_banks[2][banks]; // first and last dirty column of each bank, unused
+    uint8_t _clip_banks[banks];
+};
+
+#endif
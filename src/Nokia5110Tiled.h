@@ -0,0 +1,259 @@
+/*
+   Copyright 2017 Andrew Cassidy
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#ifndef NOKIA5110_TILED_H
+#define NOKIA5110_TILED_H
+
+#include "Nokia5110.h"
+
+/**
+ * @brief A canvas spread across a grid of displays
+ * @details The canvas is COLS displays wide and ROWS displays high, and is
+ * drawn to like one big display. There is a single frame for the whole
+ * canvas, and each display is a Nokia5110Panel that sends its own 84x48
+ * window of it, so shapes, text and patterns carry on from one display to
+ * the next without seams.
+ *
+ *  The displays can share SCLK, MOSI, D/C and RST as long as each one has its
+ *  own CE pin. display_dirty() only sends the displays that were
+ *  drawn to, and holds the bus for the whole update so they go out back to
+ *  back.
+ *
+ *  Coordinates are 8 bits, so the canvas can be up to 3 displays wide and 5
+ *  high:
+ *
+ * @code
+ * SPI bus(p6, NC, p7);
+ * Nokia5110SPI top_left(bus, p4, p3, p5), top_right(bus, p8, p3, p5);
+ * Nokia5110SPI bottom_left(bus, p9, p3, p5), bottom_right(bus, p10, p3, p5);
+ * Nokia5110Transport *transports[] = {&top_left, &top_right, &bottom_left, &bottom_right};
+ *
+ * Nokia5110Tiled<2, 2> canvas(transports); // 168x96
+ * canvas.init();
+ * canvas.fill_circle(84, 48, 30); // across all four displays
+ * canvas.display_dirty();
+ * @endcode
+ *
+ *  Four displays side by side, 336 pixels across, are not supported as one
+ *  canvas: they don't fit in 8 bit coordinates. Drawing seamlessly across
+ *  all four isn't possible. They can only be driven as two separate
+ *  Nokia5110Tiled<2, 1>, one for each half, on the same bus, with a seam
+ *  between them. That takes the same RAM as one canvas would, but
+ *  anything that crosses the seam has to be drawn on both halves, 168
+ *  pixels further left on the right half. Drawing coordinates can't be
+ *  negative, so a shape that starts on the left half only reaches the right
+ *  half through blit(), which takes a signed destination. Draw it once on a
+ *  Nokia5110Surface and blit it onto each half, which costs the surface's
+ *  RAM and a second copy. Each half also needs its own display_dirty(), and
+ *  the flush can't group the two into one bus transaction, so they are
+ *  sent one after the other:
+ *
+ * @code
+ * Nokia5110Tiled<2, 1> left(left_transports), right(right_transports);
+ * Nokia5110Surface<96, 8> label;
+ * label.print_string("Temperature 21C", 0, 0);
+ *
+ * left.blit(label, 0, 0, 95, 7, 120, 20); // x = 120 on the whole row
+ * right.blit(label, 0, 0, 95, 7, 120 - 168, 20);
+ * left.display_dirty();
+ * right.display_dirty();
+ * @endcode
+ *
+ * @tparam COLS number of displays across
+ * @tparam ROWS number of displays down
+ */
+template <uint8_t COLS, uint8_t ROWS>
+class Nokia5110Tiled : public Nokia5110Canvas {
+    static_assert(COLS > 0 && COLS * LCD_WIDTH <= 0xFF, "a tiled canvas is at most 3 displays wide, see the class docs for wider rows");
+    static_assert(ROWS > 0 && ROWS * LCD_HEIGHT <= 0xFF, "a tiled canvas is at most 5 displays high");
+
+public:
+    /**
+     * @brief constructor
+     *
+     * @param transports bus of each display, row by row from the top left.
+     * must outlive the Nokia5110Tiled object
+     */
+    Nokia5110Tiled(Nokia5110Transport *const transports[COLS * ROWS])
+        : Nokia5110Tiled(transports, typename nokia5110_detail::make_index_list<COLS * ROWS>::type()) {}
+
+    /**
+     * @brief initialize every display with given contrast and bias
+     *
+     * @param con contrast for the displays, see Nokia5110Panel::set_contrast()
+     * to set each display's contrast separately
+     * @param bias bias for the displays, should be 0x04 for the nokia 5110
+     * display. only change for other PCD8544 displays
+     */
+    void init(uint8_t con = 40, uint8_t bias = 0x04) {
+        // reset every display before setting any up, so displays that share
+        // a reset pin don't wipe each other's settings
+        reset();
+        _panels[0].transport().delay_ms(10);
+
+        for (uint8_t i = 0; i < COLS * ROWS; i++) {
+            _panels[i].set_contrast(con);
+            _panels[i].set_bias(bias);
+            _panels[i].set_mode(LCD_DISPLAYNORMAL);
+        }
+    }
+
+    /**
+     * @brief reset every display's memory
+     */
+    void reset() {
+        for (uint8_t i = 0; i < COLS * ROWS; i++) {
+            _panels[i].reset();
+        }
+        set_dirty(true);
+    }
+
+    /**
+     * @brief gets one of the displays
+     *
+     * @param col column of the display, from the left
+     * @param row row of the display, from the top
+     *
+     * @return the display's panel
+     */
+    Nokia5110Panel &panel(uint8_t col, uint8_t row) {
+        return _panels[row * COLS + col];
+    }
+
+    /**
+     * @brief sends the whole canvas to the displays
+     * @details see Nokia5110Panel::display()
+     */
+    void display() {
+        lock();
+        for (uint8_t i = 0; i < COLS * ROWS; i++) {
+            _panels[i].display();
+        }
+        unlock();
+
+        set_dirty(false);
+    }
+
+    /**
+     * @brief sends the parts of the canvas that were drawn to since the last
+     * flush
+     * @details the dirty tracker covers the whole canvas, and is split up
+     * into each display's window. displays that weren't drawn to aren't sent
+     * anything, the rest are sent their dirty spans with
+     * Nokia5110Panel::display_banks()
+     */
+    void display_dirty() {
+        uint8_t x0[LCD_BANKS];
+        uint8_t x1[LCD_BANKS];
+        bool dirty[COLS * ROWS];
+
+        // hold the bus of every display that needs sending before sending
+        // any, so displays that share a bus are sent in one go
+        for (uint8_t i = 0; i < COLS * ROWS; i++) {
+            dirty[i] = window_spans(i, x0, x1);
+            if (dirty[i]) {
+                _panels[i].transport().lock();
+            }
+        }
+
+        for (uint8_t i = 0; i < COLS * ROWS; i++) {
+            if (dirty[i]) {
+                window_spans(i, x0, x1);
+                _panels[i].display_banks(x0, x1);
+                _panels[i].transport().unlock();
+            }
+        }
+
+        set_dirty(false);
+    }
+
+private:
+    template <unsigned int... I>
+    Nokia5110Tiled(Nokia5110Transport *const transports[], nokia5110_detail::index_list<I...>)
+        : Nokia5110Canvas(_frame, COLS * LCD_WIDTH, ROWS * LCD_HEIGHT, _dirty_banks[0], _dirty_banks[1], _clip_banks),
+          _panels{Nokia5110Panel(*transports[I], window(I), COLS * LCD_WIDTH)...} {}
+
+    /**
+     * @brief gets the top left byte of a display's window
+     *
+     * @param i index of the display, row by row from the top left
+     *
+     * @return pointer into the frame
+     */
+    uint8_t *window(unsigned int i) {
+        return _frame + (i % COLS) * LCD_WIDTH + (i / COLS) * LCD_BANKS * (COLS * LCD_WIDTH);
+    }
+
+    /**
+     * @brief gets the part of the dirty tracker that is in a display's window
+     *
+     * @param i index of the display, row by row from the top left
+     * @param x0 filled with the first dirty column of each of the display's
+     * banks, in display coordinates
+     * @param x1 filled with the last dirty column of each of the display's
+     * banks, less than x0 if the bank is clean
+     *
+     * @return true if any of the window is dirty
+     */
+    bool window_spans(uint8_t i, uint8_t *x0, uint8_t *x1) {
+        int16_t left = (i % COLS) * LCD_WIDTH;
+        uint8_t top = (i / COLS) * LCD_BANKS;
+        bool dirty = false;
+
+        for (uint8_t bank = 0; bank < LCD_BANKS; bank++) {
+            int16_t lo = _dirty_x0[top + bank] - left;
+            int16_t hi = _dirty_x1[top + bank] - left;
+            lo = (lo > 0) ? lo : 0;
+            hi = (hi < LCD_WIDTH - 1) ? hi : LCD_WIDTH - 1;
+
+            if (lo <= hi) {
+                x0[bank] = lo;
+                x1[bank] = hi;
+                dirty = true;
+            } else {
+                x0[bank] = LCD_WIDTH - 1;
+                x1[bank] = 0;
+            }
+        }
+
+        return dirty;
+    }
+
+    /**
+     * @brief holds the bus of every display
+     */
+    void lock() {
+        for (uint8_t i = 0; i < COLS * ROWS; i++) {
+            _panels[i].transport().lock();
+        }
+    }
+
+    /**
+     * @brief releases the bus of every display
+     */
+    void unlock() {
+        for (uint8_t i = 0; i < COLS * ROWS; i++) {
+            _panels[i].transport().unlock();
+        }
+    }
+
+    uint8_t _frame[COLS * ROWS * LCD_BYTES];
+    uint8_t _dirty_banks[2][ROWS * LCD_BANKS]; // first and last dirty column of each bank
+    uint8_t _clip_banks[ROWS * LCD_BANKS];
+    Nokia5110Panel _panels[COLS * ROWS];
+};
+
+#endif
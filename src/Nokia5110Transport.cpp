@@ -0,0 +1,88 @@
+/*
+   Copyright 2017 Andrew Cassidy
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include "Nokia5110Transport.h"
+#include "Nokia5110.h"
+#include <new>
+
+#ifdef __MBED__
+
+Nokia5110SPI::Nokia5110SPI(PinName sce, PinName rst, PinName dc, PinName dn, PinName sclk)
+    : _sce(sce, 1), _rst(rst, 1), _dc(dc, 0) {
+    _lcd_SPI = new (_own_SPI) SPI(dn, NC, sclk);
+    _lcd_SPI->format(LCD_SPI_BITS, LCD_SPI_MODE);
+    _lcd_SPI->frequency(LCD_SPI_FREQ);
+}
+
+Nokia5110SPI::Nokia5110SPI(SPI &spi, PinName sce, PinName rst, PinName dc)
+    : _sce(sce, 1), _rst(rst, 1), _dc(dc, 0) {
+    _lcd_SPI = &spi;
+    _lcd_SPI->format(LCD_SPI_BITS, LCD_SPI_MODE);
+    _lcd_SPI->frequency(LCD_SPI_FREQ);
+}
+
+Nokia5110SPI::~Nokia5110SPI() {
+    if (_lcd_SPI == (SPI *) _own_SPI) {
+        _lcd_SPI->~SPI();
+    }
+}
+
+void Nokia5110SPI::select(bool selected) {
+    _sce.write(!selected);
+}
+
+void Nokia5110SPI::set_dc(bool data) {
+    _dc.write(data);
+}
+
+void Nokia5110SPI::set_reset(bool asserted) {
+    _rst.write(!asserted);
+}
+
+void Nokia5110SPI::write(const uint8_t *data, size_t len) {
+    _lcd_SPI->write((const char *) data, len, NULL, 0);
+}
+
+#if DEVICE_SPI_ASYNCH
+void Nokia5110SPI::write_async(const uint8_t *data, size_t len, void (*done)(void *), void *context) {
+    _done = done;
+    _context = context;
+    _lcd_SPI->transfer<uint8_t>(data, len, NULL, 0, callback(this, &Nokia5110SPI::transfer_done), SPI_EVENT_COMPLETE);
+}
+
+void Nokia5110SPI::transfer_done(int event) {
+    (void) event;
+    _done(_context);
+}
+#endif
+
+void Nokia5110SPI::lock() {
+    _lcd_SPI->lock();
+}
+
+void Nokia5110SPI::unlock() {
+    _lcd_SPI->unlock();
+}
+
+void Nokia5110SPI::delay_ms(unsigned int ms) {
+    wait_ms(ms);
+}
+
+uint32_t Nokia5110SPI::time_us() {
+    return us_ticker_read();
+}
+
+#endif
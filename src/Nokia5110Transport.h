@@ -0,0 +1,182 @@
+/*
+   Copyright 2017 Andrew Cassidy
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#ifndef NOKIA5110_TRANSPORT_H
+#define NOKIA5110_TRANSPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __MBED__
+#include <mbed.h>
+#endif
+
+/**
+ * @brief The bus a PCD8544 controller is connected to
+ * @details Nokia5110 does all of its I/O through this interface, so the driver
+ * can run on anything that can provide the four signals. Nokia5110SPI drives
+ * the real display with mbed-os, Nokia5110Emulator decodes the traffic on a
+ * host
+ */
+class Nokia5110Transport {
+public:
+    virtual ~Nokia5110Transport() {}
+
+    /**
+     * @brief sets the chip enable line
+     *
+     * @param selected true to select the display (CE low)
+     */
+    virtual void select(bool selected) = 0;
+
+    /**
+     * @brief sets the D/C line
+     *
+     * @param data true for data bytes, false for commands
+     */
+    virtual void set_dc(bool data) = 0;
+
+    /**
+     * @brief sets the reset line
+     *
+     * @param asserted true to hold the display in reset (RST low)
+     */
+    virtual void set_reset(bool asserted) = 0;
+
+    /**
+     * @brief writes bytes to the bus
+     *
+     * @param data bytes to write
+     * @param len number of bytes to write
+     */
+    virtual void write(const uint8_t *data, size_t len) = 0;
+
+    /**
+     * @brief starts writing bytes to the bus in the background
+     * @details the default implementation writes the bytes before returning
+     * and calls done straight away
+     *
+     * @param data bytes to write. must stay valid until done is called
+     * @param len number of bytes to write
+     * @param done called once the bytes are written, may be from interrupt
+     * context
+     * @param context passed to done
+     */
+    virtual void write_async(const uint8_t *data, size_t len, void (*done)(void *), void *context) {
+        write(data, len);
+        done(context);
+    }
+
+    /**
+     * @brief takes the bus for a run of transfers, when it is shared with
+     * other devices
+     * @details calls can be nested, each must be paired with unlock(). the
+     * default implementation does nothing
+     */
+    virtual void lock() {}
+
+    /**
+     * @brief releases the bus taken by lock()
+     */
+    virtual void unlock() {}
+
+    /**
+     * @brief waits for a number of milliseconds
+     *
+     * @param ms time to wait
+     */
+    virtual void delay_ms(unsigned int ms) = 0;
+
+    /**
+     * @brief reads a free running microsecond clock, used to time flushes
+     * when LCD_STATS is enabled
+     *
+     * @return current time in microseconds, or 0 if there is no clock
+     */
+    virtual uint32_t time_us() {
+        return 0;
+    }
+};
+
+#ifdef __MBED__
+/**
+ * @brief Transport for a display connected to mbed-os SPI and GPIO pins
+ * @details the pins, and the SPI bus unless it's shared, are kept inside the
+ * object, so nothing is allocated on the heap and a Nokia5110SPI can have
+ * static storage duration
+ */
+class Nokia5110SPI : public Nokia5110Transport {
+public:
+    /**
+     * @brief constructor
+     *
+     * @param sce Chip Enable pin
+     * @param rst Reset pin
+     * @param dc D/C pin
+     * @param dn data pin (MOSI)
+     * @param sclk clock pin (SCLK)
+     */
+    Nokia5110SPI(PinName sce, PinName rst, PinName dc, PinName dn, PinName sclk);
+
+    /**
+     * @brief constructor for a display on a bus shared with other devices,
+     * such as the other displays of a Nokia5110Tiled
+     *
+     * @param spi SPI bus the display is on, must outlive the Nokia5110SPI
+     * object. set to the display's format and frequency, so should only be
+     * shared with devices that use the same settings
+     * @param sce Chip Enable pin, must not be shared
+     * @param rst Reset pin
+     * @param dc D/C pin
+     */
+    Nokia5110SPI(SPI &spi, PinName sce, PinName rst, PinName dc);
+
+    virtual ~Nokia5110SPI();
+
+    virtual void select(bool selected);
+    virtual void set_dc(bool data);
+    virtual void set_reset(bool asserted);
+    virtual void write(const uint8_t *data, size_t len);
+#if DEVICE_SPI_ASYNCH
+    virtual void write_async(const uint8_t *data, size_t len, void (*done)(void *), void *context);
+#endif
+    virtual void lock();
+    virtual void unlock();
+    virtual void delay_ms(unsigned int ms);
+    virtual uint32_t time_us();
+
+private:
+#if DEVICE_SPI_ASYNCH
+    void transfer_done(int event);
+
+    void (*_done)(void *);
+    void *_context;
+#endif
+
+    // no copying, _lcd_SPI can point into the object
+    Nokia5110SPI(const Nokia5110SPI &) = delete;
+    Nokia5110SPI &operator=(const Nokia5110SPI &) = delete;
+
+    SPI *_lcd_SPI;
+    alignas(SPI) uint8_t _own_SPI[sizeof(SPI)]; // the bus when it isn't shared
+
+    DigitalOut _sce;
+    DigitalOut _rst;
+    DigitalOut _dc;
+};
+#endif
+
+#endif
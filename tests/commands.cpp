@@ -0,0 +1,81 @@
+/*
+   Copyright 2017 Andrew Cassidy
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+// Checks the controller settings against Nokia5110Emulator: each one reaches
+// the controller as a real command, even when it's out of range, and setting
+// it again to the same value sends nothing.
+
+#include "Nokia5110.h"
+#include "Nokia5110Emulator.h"
+#include <stdio.h>
+
+static Nokia5110Emulator emulator;
+static Nokia5110 lcd(emulator);
+static unsigned int failures;
+
+#define CHECK(cond)                                                      \
+    do {                                                                 \
+        if (!(cond)) {                                                   \
+            fprintf(stderr, "%s:%d: %s failed\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                  \
+        }                                                                \
+    } while (0)
+
+// sets a setting twice, the second time should send no commands
+#define CHECK_REPEAT(call, state, expected)      \
+    do {                                         \
+        lcd.call;                                \
+        CHECK(emulator.state() == (expected));   \
+        emulator.reset_counters();               \
+        lcd.call;                                \
+        CHECK(emulator.command_bytes() == 0);    \
+        CHECK(emulator.state() == (expected));   \
+    } while (0)
+
+int main() {
+    lcd.init();
+
+    for (uint8_t con = 0; con < 0x90; con += 0x0F) {
+        CHECK_REPEAT(set_contrast(con), vop, con > 0x7F ? 0x7F : con);
+    }
+    CHECK_REPEAT(set_contrast(0xFF), vop, 0x7F);
+
+    for (uint8_t bias = 0; bias < 0x0A; bias++) {
+        CHECK_REPEAT(set_bias(bias), bias, bias > 0x07 ? 0x07 : bias);
+    }
+    CHECK_REPEAT(set_bias(0xFF), bias, 0x07);
+
+    CHECK_REPEAT(set_mode(LCD_DISPLAYBLANK), display_mode, LCD_DISPLAYBLANK);
+    CHECK_REPEAT(set_mode(LCD_DISPLAYNORMAL), display_mode, LCD_DISPLAYNORMAL);
+    CHECK_REPEAT(set_mode(LCD_DISPLAYALLON), display_mode, LCD_DISPLAYALLON);
+    CHECK_REPEAT(set_mode(LCD_DISPLAYINVERTED), display_mode, LCD_DISPLAYINVERTED);
+    CHECK_REPEAT(set_mode(0x02), display_mode, LCD_DISPLAYBLANK);
+    CHECK_REPEAT(set_mode(0x08), display_mode, LCD_DISPLAYINVERTED);
+    CHECK_REPEAT(set_mode(0xFF), display_mode, LCD_DISPLAYINVERTED);
+
+    // switching between the instruction sets for each setting in turn
+    lcd.set_contrast(50);
+    lcd.set_bias(4);
+    lcd.set_mode(LCD_DISPLAYNORMAL);
+    emulator.reset_counters();
+    lcd.set_contrast(50);
+    lcd.set_bias(4);
+    lcd.set_mode(LCD_DISPLAYNORMAL);
+    CHECK(emulator.command_bytes() == 0);
+
+    printf("commands: %u failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,360 @@
+/*
+   Copyright 2017 Andrew Cassidy
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+// Renders a seeded random corpus of drawing calls and checks the frames
+// against golden frames, see the Makefile. Every primitive is drawn in all 8
+// modes with every pattern, with coordinates past the edge of the canvas and
+// near 255 so they wrap, zero radii and swapped corners.
+//
+//   raster check GOLDEN  compares the frames with GOLDEN
+//   raster write FILE    writes the frames to FILE
+
+#include "Nokia5110Surface.h"
+#include "prop5x7.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RASTER_SEED 0x5110u
+#define RASTER_FRAMES 128 // frames on an 84x48 canvas
+#define RASTER_ODD_FRAMES 32 // frames on a canvas that isn't a whole display
+#define RASTER_CALLS 6 // random calls in each frame
+
+// bytes are drawn whole, so wrapping canvases have to be a whole number of
+// banks high
+#if LCD_WRAPAROUND
+typedef Nokia5110Surface<100, 64> OddSurface;
+#else
+typedef Nokia5110Surface<100, 61> OddSurface;
+#endif
+
+typedef Nokia5110Canvas Canvas;
+
+static constexpr pattern_t diagonal_rows = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+static constexpr pattern_t bricks_rows = {0xFF, 0x01, 0x01, 0x01, 0xFF, 0x10, 0x10, 0x10};
+
+static const Canvas::Pattern diagonal_shape(diagonal_rows, Canvas::Pattern::shape);
+static const Canvas::Pattern bricks_shape(bricks_rows, Canvas::Pattern::shape);
+
+static const Canvas::Pattern *const patterns[] = {
+    &Canvas::pattern_black, &Canvas::pattern_dkgrey, &Canvas::pattern_grey, &Canvas::pattern_ltgrey,
+    &Canvas::pattern_white, &diagonal_shape, &bricks_shape
+};
+#define PATTERN_COUNT (sizeof(patterns) / sizeof(patterns[0]))
+
+enum Primitive {
+    pixel,
+    line,
+    hline,
+    vline,
+    rect,
+    filled_rect,
+    rrect,
+    filled_rrect,
+    circle,
+    filled_circle,
+    ellipse,
+    filled_ellipse,
+    text,
+    scaled_text,
+    bitmap,
+    native_bitmap,
+    wbitmap,
+    blit,
+    primitive_count
+};
+
+static_assert((RASTER_FRAMES + RASTER_ODD_FRAMES) * RASTER_CALLS >= primitive_count * 8,
+              "the corpus must be long enough to draw every primitive in every mode");
+
+static uint32_t state = RASTER_SEED;
+static uint8_t pool[512]; // random bytes for bitmaps
+static Nokia5110Surface<40, 24> source; // blitted from
+static char log_buffer[1024]; // calls made in the current frame
+static size_t log_length;
+
+// xorshift32, so the corpus is the same everywhere
+static uint32_t next() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static uint8_t below(unsigned int n) {
+    return next() % n;
+}
+
+// a coordinate on a canvas size pixels across, mostly on it, sometimes just
+// past the edge and sometimes near 255, where it wraps
+static uint8_t coordinate(uint8_t size) {
+    unsigned int kind = below(10);
+    if (kind < 7) {
+        return below(size + 8);
+    }
+    if (kind < 9) {
+        return 0xFF - below(16);
+    }
+    return next();
+}
+
+// a radius or length, 0 a quarter of the time
+static uint8_t radius(unsigned int max) {
+    return below(4) ? below(max + 1) : 0;
+}
+
+static void log_call(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+static void log_call(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(log_buffer + log_length, sizeof(log_buffer) - log_length, format, args);
+    va_end(args);
+
+    if (len > 0) {
+        log_length += ((size_t) len < sizeof(log_buffer) - log_length) ? len : sizeof(log_buffer) - log_length - 1;
+    }
+}
+
+// draws the nth call of the corpus. calls go through every primitive in
+// turn, in one mode each time round, and through the patterns at a rate that
+// doesn't line up with the primitives, so each primitive meets every mode and
+// every pattern
+static void draw_call(Canvas &canvas, unsigned int n) {
+    Primitive primitive = (Primitive) (n % primitive_count);
+    Canvas::Mode mode = (Canvas::Mode) (n / primitive_count % 8);
+    unsigned int p = n % PATTERN_COUNT;
+    const Canvas::Pattern &pattern = *patterns[p];
+    uint8_t w = canvas.width();
+    uint8_t h = canvas.height();
+    uint8_t x0 = coordinate(w), y0 = coordinate(h), x1 = coordinate(w), y1 = coordinate(h);
+    uint8_t r = radius(24), b = radius(24);
+
+    switch (primitive) {
+    case pixel:
+        log_call("  draw_pixel(%u, %u, pattern %u, mode %u)\n", x0, y0, p, mode);
+        canvas.draw_pixel(x0, y0, pattern, mode);
+        break;
+    case line:
+        log_call("  draw_line(%u, %u, %u, %u, pattern %u, mode %u)\n", x0, y0, x1, y1, p, mode);
+        canvas.draw_line(x0, y0, x1, y1, pattern, mode);
+        break;
+    case hline:
+        log_call("  draw_hline(%u, %u, %u, pattern %u, mode %u)\n", x0, x1, y0, p, mode);
+        canvas.draw_hline(x0, x1, y0, pattern, mode);
+        break;
+    case vline:
+        log_call("  draw_vline(%u, %u, %u, pattern %u, mode %u)\n", y0, y1, x0, p, mode);
+        canvas.draw_vline(y0, y1, x0, pattern, mode);
+        break;
+    case rect:
+        log_call("  draw_rect(%u, %u, %u, %u, pattern %u, mode %u)\n", x0, y0, x1, y1, p, mode);
+        canvas.draw_rect(x0, y0, x1, y1, pattern, mode);
+        break;
+    case filled_rect:
+        log_call("  fill_rect(%u, %u, %u, %u, pattern %u, mode %u)\n", x0, y0, x1, y1, p, mode);
+        canvas.fill_rect(x0, y0, x1, y1, pattern, mode);
+        break;
+    case rrect:
+        log_call("  draw_rrect(%u, %u, %u, %u, %u, pattern %u, mode %u)\n", x0, y0, x1, y1, r, p, mode);
+        canvas.draw_rrect(x0, y0, x1, y1, r, pattern, mode);
+        break;
+    case filled_rrect:
+        log_call("  fill_rrect(%u, %u, %u, %u, %u, pattern %u, mode %u)\n", x0, y0, x1, y1, r, p, mode);
+        canvas.fill_rrect(x0, y0, x1, y1, r, pattern, mode);
+        break;
+    case circle:
+        log_call("  draw_circle(%u, %u, %u, pattern %u, mode %u)\n", x0, y0, r, p, mode);
+        canvas.draw_circle(x0, y0, r, pattern, mode);
+        break;
+    case filled_circle:
+        log_call("  fill_circle(%u, %u, %u, pattern %u, mode %u)\n", x0, y0, r, p, mode);
+        canvas.fill_circle(x0, y0, r, pattern, mode);
+        break;
+    case ellipse:
+        log_call("  draw_ellipse(%u, %u, %u, %u, pattern %u, mode %u)\n", x0, y0, r, b, p, mode);
+        canvas.draw_ellipse(x0, y0, r, b, pattern, mode);
+        break;
+    case filled_ellipse:
+        log_call("  fill_ellipse(%u, %u, %u, %u, pattern %u, mode %u)\n", x0, y0, r, b, p, mode);
+        canvas.fill_ellipse(x0, y0, r, b, pattern, mode);
+        break;
+    case text: {
+        static const char *const strings[] = {"Hello", "gjpqy|", "AV.Wi!", "0123456789", "\x01\x7F ~"};
+        const char *str = strings[below(5)];
+        bool proportional = below(2);
+        int8_t chars = below(3) ? -1 : below(4);
+        canvas.set_font(proportional ? &prop5x7 : NULL);
+        log_call("  print_string(\"%s\", %u, %u, %d, mode %u) font %u\n", str, x0, y0, chars, mode, proportional);
+        canvas.print_string(str, x0, y0, chars, mode);
+        canvas.set_font(NULL);
+        break;
+    }
+    case scaled_text: {
+        static const char *const strings[] = {"42", "7.5", "-0", "Ag"};
+        const char *str = strings[below(4)];
+        uint8_t scale = below(6);
+        bool proportional = below(2);
+        canvas.set_font(proportional ? &prop5x7 : NULL);
+        log_call("  print_scaled(\"%s\", %u, %u, %u, mode %u) font %u\n", str, x0, y0, scale, mode, proportional);
+        canvas.print_scaled(str, x0, y0, scale, mode);
+        canvas.set_font(NULL);
+        break;
+    }
+    case bitmap: {
+        uint8_t bw = 1 + below(40), bh = 1 + below(40);
+        unsigned int offset = below(64);
+        log_call("  draw_bitmap(pool + %u, %u, %u, %u, %u, mode %u)\n", offset, x0, y0, bw, bh, mode);
+        canvas.draw_bitmap(pool + offset, x0, y0, bw, bh, mode);
+        break;
+    }
+    case native_bitmap: {
+        uint8_t bw = 1 + below(40), bh = 1 + below(40);
+        unsigned int offset = below(64);
+        log_call("  draw_native_bitmap(pool + %u, %u, %u, %u, %u, mode %u)\n", offset, x0, y0, bw, bh, mode);
+        canvas.draw_native_bitmap(pool + offset, x0, y0, bw, bh, mode);
+        break;
+    }
+    case wbitmap: {
+        // type 0 WBMP header with single byte dimensions, then the pool
+        uint8_t wbmp[4 + 240];
+        uint8_t bw = 1 + below(40), bh = 1 + below(40);
+        wbmp[0] = 0;
+        wbmp[1] = 0;
+        wbmp[2] = bw;
+        wbmp[3] = bh;
+        memcpy(wbmp + 4, pool + below(64), sizeof(wbmp) - 4);
+        log_call("  draw_wbitmap(%ux%u, %u, %u, mode %u)\n", bw, bh, x0, y0, mode);
+        canvas.draw_wbitmap(wbmp, x0, y0, mode);
+        break;
+    }
+    case blit: {
+        // from the source surface, or overlapping from the canvas itself
+        bool self = below(3) == 0;
+        Canvas &src = self ? canvas : (Canvas &) source;
+        uint8_t sx0 = below(src.width() + 4), sy0 = below(src.height() + 4);
+        uint8_t sx1 = below(src.width() + 4), sy1 = below(src.height() + 4);
+        int16_t dx = (int16_t) below(w + 40) - 20, dy = (int16_t) below(h + 40) - 20;
+        log_call("  blit(%s, %u, %u, %u, %u, %d, %d, mode %u)\n", self ? "self" : "source", sx0, sy0, sx1, sy1,
+                 dx, dy, mode);
+        canvas.blit(src, sx0, sy0, sx1, sy1, dx, dy, mode);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// draws one frame of the corpus onto a canvas with random content
+static void draw_frame(Canvas &canvas, unsigned int frame) {
+    log_length = 0;
+    log_buffer[0] = '\0';
+
+    for (uint8_t bank = 0; bank < (canvas.height() + 7) / 8; bank++) {
+        for (uint8_t col = 0; col < canvas.width(); col++) {
+            canvas.draw_byte(col, bank, below(4) ? next() : 0x00);
+        }
+    }
+
+    if (below(3) == 0) {
+        uint8_t x0 = below(canvas.width()), y0 = below(canvas.height());
+        uint8_t x1 = below(canvas.width()), y1 = below(canvas.height());
+        log_call("  set_clip(%u, %u, %u, %u)\n", x0, y0, x1, y1);
+        canvas.set_clip(x0, y0, x1, y1);
+    }
+
+    for (unsigned int i = 0; i < RASTER_CALLS; i++) {
+        draw_call(canvas, frame * RASTER_CALLS + i);
+    }
+
+    canvas.reset_clip();
+}
+
+static bool render(FILE *golden, FILE *out) {
+    static Nokia5110Surface<LCD_WIDTH, LCD_HEIGHT> display;
+    static OddSurface odd;
+    static uint8_t expected[sizeof(OddSurface)];
+    unsigned int failures = 0;
+
+    for (unsigned int i = 0; i < sizeof(pool); i++) {
+        pool[i] = next();
+    }
+    for (uint8_t bank = 0; bank < 3; bank++) {
+        for (uint8_t col = 0; col < source.width(); col++) {
+            source.draw_byte(col, bank, next());
+        }
+    }
+
+    for (unsigned int frame = 0; frame < RASTER_FRAMES + RASTER_ODD_FRAMES; frame++) {
+        bool is_odd = frame >= RASTER_FRAMES;
+        Canvas &canvas = is_odd ? (Canvas &) odd : (Canvas &) display;
+        const uint8_t *data = is_odd ? odd.data() : display.data();
+        size_t bytes = canvas.width() * ((canvas.height() + 7) / 8);
+
+        draw_frame(canvas, frame);
+
+        if (out && fwrite(data, 1, bytes, out) != bytes) {
+            fprintf(stderr, "couldn't write frame %u\n", frame);
+            return false;
+        }
+
+        if (golden) {
+            if (fread(expected, 1, bytes, golden) != bytes) {
+                fprintf(stderr, "golden frames end before frame %u\n", frame);
+                return false;
+            }
+            if (memcmp(expected, data, bytes) != 0) {
+                size_t i = 0;
+                while (expected[i] == data[i]) {
+                    i++;
+                }
+                fprintf(stderr, "frame %u (%ux%u) differs at column %u bank %u: 0x%02X, expected 0x%02X\n%s", frame,
+                        canvas.width(), canvas.height(), (unsigned int) (i % canvas.width()),
+                        (unsigned int) (i / canvas.width()), data[i], expected[i], log_buffer);
+                failures++;
+            }
+        }
+    }
+
+    if (golden && fgetc(golden) != EOF) {
+        fprintf(stderr, "golden frames go on past the corpus\n");
+        return false;
+    }
+
+    printf("%u frames, %u calls, %u failed\n", RASTER_FRAMES + RASTER_ODD_FRAMES,
+           (RASTER_FRAMES + RASTER_ODD_FRAMES) * RASTER_CALLS, failures);
+    return failures == 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3 || (strcmp(argv[1], "check") != 0 && strcmp(argv[1], "write") != 0)) {
+        fprintf(stderr, "usage: %s check GOLDEN | write FILE\n", argv[0]);
+        return 2;
+    }
+
+    bool check = strcmp(argv[1], "check") == 0;
+    FILE *file = fopen(argv[2], check ? "rb" : "wb");
+    if (!file) {
+        perror(argv[2]);
+        return 2;
+    }
+
+    bool ok = check ? render(file, NULL) : render(NULL, file);
+    fclose(file);
+
+    return ok ? 0 : 1;
+}
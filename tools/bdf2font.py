@@ -0,0 +1,249 @@
+#!/usr/bin/env python3
+#
+#  Copyright 2017 Andrew Cassidy
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+"""Converts a BDF bitmap font to a Nokia5110Font.
+
+Writes a header defining the font as constexpr tables, see
+src/Nokia5110Font.h for the format:
+
+    python3 tools/bdf2font.py --rle helvR08.bdf helv8 > helv8.h
+
+Each glyph is rendered into a cell as tall as the font's ascent plus its
+descent and as wide as its DWIDTH, then split into column bytes. Blank
+columns either side of the glyph are trimmed, unless --fixed is given, in
+which case every glyph is stored the full width of the font's bounding box
+and no glyph table is written.
+"""
+
+import argparse
+import sys
+
+
+def parse_bdf(lines):
+    """Reads a BDF file.
+
+    Returns (ascent, descent, bbox width, {encoding: (dwidth, bbx, rows)}),
+    where bbx is (width, height, x offset, y offset) and rows are integers
+    with the leftmost pixel in the most significant bit of the row's bytes.
+    """
+    ascent = descent = None
+    bbox = None
+    glyphs = {}
+    glyph = None
+
+    it = iter(lines)
+    for line in it:
+        words = line.split()
+        if not words:
+            continue
+        key = words[0]
+
+        if key == 'FONTBOUNDINGBOX':
+            bbox = [int(w) for w in words[1:5]]
+        elif key == 'FONT_ASCENT':
+            ascent = int(words[1])
+        elif key == 'FONT_DESCENT':
+            descent = int(words[1])
+        elif key == 'STARTCHAR':
+            glyph = {'encoding': -1, 'dwidth': None, 'bbx': None}
+        elif key == 'ENCODING' and glyph is not None:
+            glyph['encoding'] = int(words[1])
+        elif key == 'DWIDTH' and glyph is not None:
+            glyph['dwidth'] = int(words[1])
+        elif key == 'BBX' and glyph is not None:
+            glyph['bbx'] = [int(w) for w in words[1:5]]
+        elif key == 'BITMAP' and glyph is not None:
+            rows = []
+            for row in it:
+                if row.strip() == 'ENDCHAR':
+                    break
+                rows.append(int(row.strip() or '0', 16))
+            bbx = glyph['bbx'] or bbox
+            dwidth = glyph['dwidth'] if glyph['dwidth'] is not None else bbx[0] + bbx[2]
+            if glyph['encoding'] >= 0:
+                glyphs[glyph['encoding']] = (dwidth, bbx, rows)
+            glyph = None
+
+    if bbox is None:
+        raise ValueError('no FONTBOUNDINGBOX')
+    if ascent is None:
+        ascent = bbox[1] + bbox[3]
+    if descent is None:
+        descent = -bbox[3]
+
+    return ascent, descent, bbox[0], glyphs
+
+
+def render(glyph, ascent, height, width):
+    """Draws a glyph into a cell, returns a list of columns, each a list of
+    pixel values top to bottom. Columns of a glyph with a negative left
+    bearing that fall before the start of the cell are clipped off, since
+    glyphs can't overlap the one before them."""
+    dwidth, (w, h, xoff, yoff), rows = glyph
+    width = max(width, dwidth, w + xoff)
+    bits = (w + 7) // 8 * 8  # bits in each row of the bitmap
+    columns = [[0] * height for _ in range(width)]
+
+    for r, row in enumerate(rows[:h]):
+        y = ascent - (yoff + h) + r
+        if y < 0 or y >= height:
+            continue
+        for c in range(w):
+            x = xoff + c
+            if x < 0:
+                continue
+            if row & (1 << (bits - 1 - c)):
+                columns[x][y] = 1
+
+    return columns
+
+
+def glyph_bytes(columns, height):
+    """Converts columns to the bank format: the bytes of each column's top 8
+    rows, then the next 8, top row in the least significant bit."""
+    out = []
+    for bank in range(0, height, 8):
+        for column in columns:
+            byte = 0
+            for bit, pixel in enumerate(column[bank:bank + 8]):
+                byte |= pixel << bit
+            out.append(byte)
+    return out
+
+
+def rle(data):
+    """Run length encodes bytes, see Nokia5110GlyphReader."""
+    out = []
+    literal = []
+    i = 0
+
+    def flush():
+        while literal:
+            chunk = literal[:0x7F]
+            del literal[:0x7F]
+            out.append(len(chunk))
+            out.extend(chunk)
+
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and data[i + run] == data[i] and run < 0x7F:
+            run += 1
+        if run >= 3:
+            flush()
+            out.extend([0x80 | run, data[i]])
+            i += run
+        else:
+            literal.extend(data[i:i + run])
+            i += run
+    flush()
+
+    return out
+
+
+def c_bytes(data, indent='    '):
+    lines = []
+    for i in range(0, len(data), 12):
+        lines.append(indent + ', '.join('0x%02X' % b for b in data[i:i + 12]) + ',')
+    return '\n'.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='converts a BDF font to a Nokia5110Font header')
+    parser.add_argument('bdf', help='BDF file to read')
+    parser.add_argument('name', help='name of the Nokia5110Font to define')
+    parser.add_argument('--first', type=lambda s: int(s, 0), default=0x20, help='first character (default 0x20)')
+    parser.add_argument('--last', type=lambda s: int(s, 0), default=0x7E, help='last character (default 0x7E)')
+    parser.add_argument('--spacing', type=int, default=0, help='blank columns between glyphs (default 0, BDF widths usually include it)')
+    parser.add_argument('--fixed', action='store_true', help='store every glyph at full width, with no glyph table')
+    parser.add_argument('--rle', action='store_true', help='run length encode the glyphs')
+    args = parser.parse_args()
+
+    if args.fixed and args.rle:
+        parser.error('fixed width fonts can\'t be compressed')
+    if not 0 <= args.first <= args.last <= 0xFF:
+        parser.error('characters must be in 0x00-0xFF')
+
+    with open(args.bdf) as f:
+        ascent, descent, bbox_width, glyphs = parse_bdf(f)
+
+    height = ascent + descent
+    if not 0 < height < 256:
+        raise SystemExit('font height %d is out of range' % height)
+
+    blank = (0, (0, 0, 0, 0), [])
+    default = glyphs.get(ord('?'), blank)
+    min_width = bbox_width if args.fixed else 0
+
+    data = []
+    table = []
+    widest = 0
+    raw_bytes = 0
+    for code in range(args.first, args.last + 1):
+        columns = render(glyphs.get(code, default), ascent, height, min_width)
+        if args.fixed:
+            data.extend(glyph_bytes(columns[:bbox_width], height))
+            continue
+
+        inked = [i for i, column in enumerate(columns) if any(column)]
+        left = inked[0] if inked else 0
+        right = inked[-1] + 1 if inked else 0
+        advance = len(columns)
+
+        stored = glyph_bytes(columns[left:right], height)
+        raw_bytes += len(stored)
+        if args.rle:
+            stored = rle(stored)
+
+        if len(data) + len(stored) > 0xFFFF:
+            raise SystemExit('font data is over 64KiB')
+        if advance > 255:
+            raise SystemExit('character 0x%02X is over 255 columns wide' % code)
+
+        table.append((len(data), left, right - left, advance, code))
+        data.extend(stored)
+        widest = max(widest, advance)
+
+    if args.rle and len(data) >= raw_bytes:
+        sys.stderr.write('warning: compressing makes the glyphs bigger, %d bytes instead of %d\n' % (len(data), raw_bytes))
+
+    out = sys.stdout
+    out.write('// generated by tools/bdf2font.py from %s, do not edit\n' % args.bdf.split('/')[-1])
+    out.write('// %d rows, characters 0x%02X to 0x%02X, %d bytes\n\n' % (height, args.first, args.last, len(data) + 5 * len(table)))
+    guard = args.name.upper() + '_H'
+    out.write('#ifndef %s\n#define %s\n\n#include "Nokia5110Font.h"\n\n' % (guard, guard))
+
+    out.write('static constexpr uint8_t %s_data[%d] = {\n%s\n};\n\n' % (args.name, len(data), c_bytes(data)))
+
+    if args.fixed:
+        glyph_table = 'NULL'
+        width = bbox_width
+    else:
+        out.write('static constexpr Nokia5110Glyph %s_glyphs[%d] = {\n' % (args.name, len(table)))
+        for offset, left, width, advance, code in table:
+            name = repr(chr(code)) if 0x20 <= code < 0x7F else '0x%02X' % code
+            out.write('    {%d, %d, %d, %d}, // %s\n' % (offset, left, width, advance, name))
+        out.write('};\n\n')
+        glyph_table = args.name + '_glyphs'
+        width = widest
+
+    out.write('static constexpr Nokia5110Font %s = {%s_data, %s, 0x%02X, 0x%02X, %d, %d, %d, %s};\n\n' % (
+        args.name, args.name, glyph_table, args.first, args.last, width, height, args.spacing,
+        'true' if args.rle else 'false'))
+    out.write('#endif\n')
+
+
+if __name__ == '__main__':
+    main()